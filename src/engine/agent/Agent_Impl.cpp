@@ -3,9 +3,11 @@
 #include "helper/HL_String.h"
 #include "helper/HL_StreamState.h"
 #include "helper/HL_VariantMap.h"
+#include "helper/HL_RtpMemoryPool.h"
 // #include "helper/HL_CsvReader.h"
 // #include "helper/HL_Base64.h"
 #include "media/MT_CodecList.h"
+#include "media/MT_CodecStatePool.h"
 #include "audio/Audio_Null.h"
 // #include <fstream>
 
@@ -210,12 +212,24 @@ void AgentImpl::processStart(JsonCpp::Value& request, JsonCpp::Value &answer)
     // Process config (can be sent via start command as well)
     // processConfig(request, answer);
 
-    // Start socket thread
+    // Start socket threads. Number of reactor threads can be set via start command only
+    if (request.isMember("socket_threads"))
+        SocketHeap::instance().setShardCount(request["socket_threads"].asUInt());
+    if (request.isMember("socket_uring"))
+        SocketHeap::instance().setIoUring(request["socket_uring"].asBool());
+    if (request.isMember("socket_rcvbuf") || request.isMember("socket_sndbuf"))
+        SocketHeap::instance().setBufferSizes(request.get("socket_rcvbuf", 0).asUInt(), request.get("socket_sndbuf", 0).asUInt());
+    if (request.isMember("media_port"))
+        SocketHeap::instance().setMultiplexPort(request["media_port"].asUInt(), request.get("media_sockets", 1).asUInt());
     SocketHeap::instance().start();
 
     // Initialize terminal
     auto settings = MT::CodecList::Settings::getClientSettings();
 
+    // Adaptive playout time-stretches audio to follow network jitter; it is off unless requested
+    if (request.isMember("adaptive_playout"))
+        settings.mAdaptivePlayout = request["adaptive_playout"].asBool();
+
     mTerminal = std::make_shared<MT::Terminal>(settings);
 
     // Enable/disable codecs
@@ -522,6 +536,14 @@ void AgentImpl::processGetMediaStats(JsonCpp::Value& request, JsonCpp::Value& an
             answer["rtp_lost"] = result[SessionInfo_LostRtp].asInt();
         if (result.exists(SessionInfo_DroppedRtp))
             answer["rtp_dropped"] = result[SessionInfo_DroppedRtp].asInt();
+        if (result.exists(SessionInfo_LocalDrops))
+            answer["rtp_local_drops"] = result[SessionInfo_LocalDrops].asInt();
+        if (result.exists(SessionInfo_FecRecovered))
+            answer["rtp_fec_recovered"] = result[SessionInfo_FecRecovered].asInt();
+        answer["local_drops_total"] = static_cast<JsonCpp::UInt64>(SocketHeap::instance().localDrops());
+        answer["rtp_pool_hit_rate"] = RtpMemoryPool::instance().hitRate();
+        answer["rtp_pool_high_water"] = static_cast<JsonCpp::UInt64>(RtpMemoryPool::instance().highWaterBytes());
+        answer["codec_pool_hit_rate"] = MT::CodecStatePool::instance().hitRate();
 
         if (result.exists(SessionInfo_SentRtp))
             answer["rtp_sent"] = result[SessionInfo_SentRtp].asInt();
@@ -0,0 +1,129 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "Audio_TimeStretch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Audio;
+
+// Pitch period range in microseconds
+#define TIMESTRETCH_MIN_PERIOD_US 2500
+#define TIMESTRETCH_MAX_PERIOD_US 15000
+
+// Coarse period search runs at this rate
+#define TIMESTRETCH_SEARCH_RATE 4000
+
+// Normalized correlation required to treat audio as periodic
+#define TIMESTRETCH_MIN_CORRELATION 0.9
+
+// Mean square below this level (about -52 dBFS) is treated as background noise - period does not matter
+#define TIMESTRETCH_LOW_ENERGY (80.0 * 80.0)
+
+static double correlation(const int16_t* x, size_t lag, size_t window, size_t step = 1)
+{
+    double xy = 0.0, xx = 0.0, yy = 0.0;
+    for (size_t i = 0; i < window; i += step)
+    {
+        double a = x[i], b = x[i + lag];
+        xy += a * b;
+        xx += a * a;
+        yy += b * b;
+    }
+    if (xx <= 0.0 || yy <= 0.0)
+        return 0.0;
+    return xy / std::sqrt(xx * yy);
+}
+
+TimeStretch::TimeStretch()
+{}
+
+size_t TimeStretch::findPeriod(const int16_t* samples, size_t count, int rate)
+{
+    size_t minPeriod = size_t(rate) * TIMESTRETCH_MIN_PERIOD_US / 1000000,
+           maxPeriod = std::min(size_t(rate) * TIMESTRETCH_MAX_PERIOD_US / 1000000, count / 2);
+    if (!minPeriod || maxPeriod < minPeriod)
+        return 0;
+
+    double energy = 0.0;
+    for (size_t i = 0; i < count; i++)
+        energy += double(samples[i]) * samples[i];
+    if (energy / count < TIMESTRETCH_LOW_ENERGY)
+        return maxPeriod;
+
+    // Coarse search on decimated signal
+    size_t factor = std::max<size_t>(1, size_t(rate) / TIMESTRETCH_SEARCH_RATE);
+    size_t decimatedCount = count / factor;
+    mDecimated.resize(decimatedCount);
+    for (size_t i = 0; i < decimatedCount; i++)
+    {
+        int sum = 0;
+        for (size_t j = 0; j < factor; j++)
+            sum += samples[i * factor + j];
+        mDecimated[i] = static_cast<int16_t>(sum / int(factor));
+    }
+
+    size_t coarse = 0;
+    double best = -1.0;
+    for (size_t lag = std::max<size_t>(1, minPeriod / factor); lag <= maxPeriod / factor && lag * 2 <= decimatedCount; lag++)
+    {
+        double c = correlation(mDecimated.data(), lag, lag);
+        if (c > best)
+        {
+            best = c;
+            coarse = lag * factor;
+        }
+    }
+    if (!coarse)
+        return 0;
+
+    // Refine around coarse period at full rate
+    size_t result = 0;
+    best = -1.0;
+    size_t from = coarse > factor ? coarse - factor : 1,
+           to = std::min(coarse + factor, maxPeriod);
+    for (size_t lag = std::max(from, minPeriod); lag <= to; lag++)
+    {
+        double c = correlation(samples, lag, lag);
+        if (c > best)
+        {
+            best = c;
+            result = lag;
+        }
+    }
+
+    return best >= TIMESTRETCH_MIN_CORRELATION ? result : 0;
+}
+
+size_t TimeStretch::accelerate(int16_t* samples, size_t count, int rate)
+{
+    size_t period = findPeriod(samples, count, rate);
+    if (!period)
+        return count;
+
+    // First period fades into the second one; the result replaces both
+    for (size_t i = 0; i < period; i++)
+        samples[i] = static_cast<int16_t>((int(samples[i]) * int(period - i) + int(samples[i + period]) * int(i)) / int(period));
+
+    memmove(samples + period, samples + 2 * period, (count - 2 * period) * sizeof(int16_t));
+    return count - period;
+}
+
+size_t TimeStretch::expand(int16_t* samples, size_t count, size_t capacity, int rate)
+{
+    size_t period = findPeriod(samples, count, rate);
+    if (!period || count + period > capacity)
+        return count;
+
+    // Original second period onwards moves one period later; inserted period fades
+    // from the second period (continuing the first) into the first one (leading into the moved second)
+    memmove(samples + 2 * period, samples + period, (count - period) * sizeof(int16_t));
+    for (size_t i = 0; i < period; i++)
+        samples[period + i] = static_cast<int16_t>((int(samples[period + i]) * int(period - i) + int(samples[i]) * int(i)) / int(period));
+
+    return count + period;
+}
@@ -0,0 +1,39 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __AUDIO_TIME_STRETCH_H
+#define __AUDIO_TIME_STRETCH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Audio
+{
+    // Changes duration of mono 16-bit audio by one pitch period without changing pitch -
+    // the same idea as WebRTC NetEq accelerate / preemptive expand. The period is found by
+    // normalized autocorrelation; the removed or repeated period is cross-faded with its neighbour.
+    // Voiced audio is changed only when correlation is strong; low energy audio is always changed.
+    // Both operations work in place and return new number of samples (unchanged if audio is not suitable).
+    class TimeStretch
+    {
+    public:
+        TimeStretch();
+
+        // Removes one period. Returns samples count after operation.
+        size_t accelerate(int16_t* samples, size_t count, int rate);
+
+        // Inserts one period; 'capacity' is size of buffer in samples. Returns samples count after operation.
+        size_t expand(int16_t* samples, size_t count, size_t capacity, int rate);
+
+    protected:
+        std::vector<int16_t> mDecimated;
+
+        // Returns best period in samples for [2.5..15] ms range limited by count / 2, or 0 if signal is not periodic enough
+        size_t findPeriod(const int16_t* samples, size_t count, int rate);
+    };
+}
+
+#endif
@@ -64,7 +64,7 @@ void AudioProvider::configureMediaObserver(MT::Stream::MediaObserver *observer,
 }
 
 // Processes incoming data
-void  AudioProvider::processData(const PDatagramSocket& s, const void* dataBuffer, int dataSize, InternetAddress& source)
+void  AudioProvider::processData(const PDatagramSocket& s, const void* dataBuffer, int dataSize, InternetAddress& source, DatagramTime receiveTime)
 {
     if (!mActiveStream)
         return;
@@ -72,7 +72,7 @@ void  AudioProvider::processData(const PDatagramSocket& s, const void* dataBuffe
     if (RtpHelper::isRtpOrRtcp(dataBuffer, dataSize))
     {
         ICELogMedia(<<"Adding new data to stream processing");
-        mActiveStream->dataArrived(s, dataBuffer, dataSize, source);
+        mActiveStream->dataArrived(s, dataBuffer, dataSize, source, receiveTime);
     }
 }
 
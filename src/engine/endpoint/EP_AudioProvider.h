@@ -35,7 +35,7 @@ public:
   void          setDestinationAddress(const RtpPair<InternetAddress>& addr) override;
 
   // Processes incoming data
-  void          processData(const PDatagramSocket& s, const void* dataBuffer, int dataSize, InternetAddress& source) override;
+  void          processData(const PDatagramSocket& s, const void* dataBuffer, int dataSize, InternetAddress& source, DatagramTime receiveTime) override;
 
   // This method is called by user agent to send ICE packet from mediasocket
   void          sendData(const PDatagramSocket& s, InternetAddress& destination, const void* dataBuffer, unsigned int datasize) override;
@@ -986,6 +986,7 @@ void UserAgent::onAnswer(resip::InviteSessionHandle h, const resip::SipMessage&
             {
                 stream.provider()->sessionTerminated(); // close corresponding media
                 stream.setProvider( PDataProvider() );  // free provider
+                s->invalidateSocketRoutes();
                 SocketHeap::instance().freeSocketPair( stream.socket4() ); // close provider's socket ip4
                 SocketHeap::instance().freeSocketPair( stream.socket6() ); // close provider's socket ip6
                 s->mIceStack->removeStream( stream.iceInfo().mStreamId ); // remove stream from ice stack
@@ -9,6 +9,7 @@
 #include "../media/MT_Stream.h"
 #include "../helper/HL_Log.h"
 #include "../helper/HL_Sync.h"
+#include "../helper/HL_DatagramMux.h"
 #include "../helper/HL_String.h"
 
 #define LOG_SUBSYSTEM "engine"
@@ -350,6 +351,7 @@ void Session::stop()
             // Drop the references so the destructor's cleanup does not free them again
             dataStream.setSocket4(RtpPair<PDatagramSocket>());
             dataStream.setSocket6(RtpPair<PDatagramSocket>());
+            invalidateSocketRoutes();
         }
     }
 
@@ -469,6 +471,8 @@ void Session::getSessionInfo(Session::InfoOptions options, VariantMap& info)
     info[SessionInfo_ReceivedRtcp] = static_cast<int>(stat.mReceivedRtcp);
     info[SessionInfo_LostRtp] = static_cast<int>(stat.mPacketLoss);
     info[SessionInfo_DroppedRtp] = static_cast<int>(stat.mPacketDropped);
+    info[SessionInfo_LocalDrops] = static_cast<int>(stat.mLocalDrops);
+    info[SessionInfo_FecRecovered] = static_cast<int>(stat.mFecRecovered);
     info[SessionInfo_SentRtp] = static_cast<int>(stat.mSentRtp);
     info[SessionInfo_SentRtcp] = static_cast<int>(stat.mSentRtcp);
     if (stat.mFirstRtpTime)
@@ -504,63 +508,119 @@ PAccount Session::account()
     return mAccount;
 }
 
-void Session::onReceivedData(PDatagramSocket socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize)
+void Session::onReceivedData(PDatagramSocket socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize, DatagramTime receiveTime)
 {
     Lock l(mGuard);
 
     if (mTerminated)
         return;
 
-    // Check if it STUN packet and must be processed by ICE stack
-    //ICELogDebug (<< "Received UDP packet from " << src.ip() << ":" << src.port());
-    ice::ByteBuffer received(receivedPtr, receivedSize);
-    received.setRemoteAddress(src);
+    processReceivedData(socket, src, receivedPtr, receivedSize, receiveTime);
+}
+
+void Session::onReceivedBatch(PDatagramSocket socket, DatagramBatch& batch)
+{
+    Lock l(mGuard);
 
-    ice::ByteBuffer plain;
+    for (unsigned i=0; i<batch.count() && !mTerminated; i++)
+        processReceivedData(socket, batch.sourceAt(i), batch.dataAt(i), batch.sizeAt(i), batch.timeAt(i));
+}
 
-    if (ice::Stack::isStun(received))
+void Session::processReceivedData(const PDatagramSocket& socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize, DatagramTime receiveTime)
+{
+    //ICELogDebug (<< "Received UDP packet from " << src.ip() << ":" << src.port());
+    // Media is passed further by pointer to socket receive buffer - ice::ByteBuffer (a copy) is built for STUN only.
+    const uint8_t* data = static_cast<const uint8_t*>(receivedPtr);
+    unsigned size = receivedSize;
+
+    PacketKind kind = RtpHelper::classify(data, size);
+    if (kind == PacketKind::TurnChannel)
     {
-        // Check if it is Data indication packet
-        if (ice::Stack::isDataIndication(received, &plain))
-        {
-            received = plain;
-        }
+        // Skip TURN prefix by moving the pointer; payload is STUN or media
+        int prefix = size >= 4 ? (data[0] << 8) | data[1] : -1;
+        if (std::find(mTurnPrefixList.begin(), mTurnPrefixList.end(), prefix) == mTurnPrefixList.end())
+            return;
+        data += 4;
+        size -= 4;
+        kind = RtpHelper::classify(data, size);
     }
-    else // Check if packet is prefixed with TURN prefix
-        if (received.size() >= 4)
-        {
-            bool turnPrefix = false;
-            for (unsigned i=0; i<mTurnPrefixList.size() && !turnPrefix; i++)
-                turnPrefix |= ice::Stack::isChannelData(received, mTurnPrefixList[i]);
-            if (turnPrefix)
-                received.erase(0, 4);
-        }
 
-    // Now process actual stun packet - it could be wrapped in Data Indication or Channel Data
-    if (ice::Stack::isStun(received))
+    const SocketRoute* route = findSocketRoute(socket.get());
+
+    switch (kind)
     {
-        // Try to process incoming data by ICE stack
-        int component = -1, stream = -1;
-        if (mIceStack->findStreamAndComponent(socket->family(), socket->localport(), &stream, &component))
+    case PacketKind::RtpRtcp:
+        if (route && route->mProvider)
+            route->mProvider->processData(socket, data, size, src, receiveTime);
+        break;
+
+    case PacketKind::Stun:
         {
-            ice::ByteBuffer buffer(receivedPtr, receivedSize);
-            buffer.setRemoteAddress(src);
-            /*bool processed = */mIceStack->processIncomingData(stream, component, buffer);
+            ice::ByteBuffer received(data, size, ice::ByteBuffer::CopyBehavior::UseExternal);
+            received.setRemoteAddress(src);
+            if (!ice::Stack::isStun(received))
+                break;
+
+            // Check if it is Data indication packet - it can carry media as well
+            ice::ByteBuffer plain;
+            if (ice::Stack::isDataIndication(received, &plain) && !ice::Stack::isStun(plain))
+            {
+                if (route && route->mProvider)
+                    route->mProvider->processData(socket, plain.data(), plain.size(), src, receiveTime);
+                break;
+            }
+
+            // Try to process incoming data by ICE stack
+            int component = -1, stream = -1;
+            if (route && route->mIceComponent != -1)
+            {
+                stream = route->mIceStream;
+                component = route->mIceComponent;
+            }
+
+            if (stream != -1 || mIceStack->findStreamAndComponent(socket->family(), socket->localport(), &stream, &component))
+            {
+                ice::ByteBuffer buffer(receivedPtr, receivedSize);
+                buffer.setRemoteAddress(src);
+                /*bool processed = */mIceStack->processIncomingData(stream, component, buffer);
+            }
         }
+        break;
+
+    default:
+        // DTLS/ZRTP are not supported; just ignore these data
+        break;
     }
-    else
+}
+
+void Session::invalidateSocketRoutes()
+{
+    mSocketRoutesDirty = true;
+}
+
+const Session::SocketRoute* Session::findSocketRoute(DatagramSocket* socket)
+{
+    if (mSocketRoutesDirty.exchange(false))
     {
-        // Find provider responsible for processing
-        PDataProvider provider = this->findProviderByPort(socket->family(), socket->localport());
-        if (provider)
+        mSocketRoutes.clear();
+        for (Stream& s: mStreamList)
         {
-            provider->processData(socket, receivedPtr, receivedSize, src);
-        }
-        else
-        {
-            // Just ignore these data
+            IceInfo ii = s.iceInfo();
+            for (RtpPair<PDatagramSocket>* pair: {&s.socket4(), &s.socket6()})
+            {
+                if (pair->mRtp)
+                    mSocketRoutes.push_back({pair->mRtp.get(), s.provider(), ii.mStreamId, ii.mComponentId.mRtp});
+                if (pair->mRtcp && pair->mRtcp != pair->mRtp)
+                    mSocketRoutes.push_back({pair->mRtcp.get(), s.provider(), ii.mStreamId, ii.mComponentId.mRtcp});
+            }
         }
     }
+
+    // Few entries per session - linear scan over flat vector is cheaper than any map
+    for (const SocketRoute& r: mSocketRoutes)
+        if (r.mSocket == socket)
+            return &r;
+    return nullptr;
 }
 
 // Called when new candidate is gathered
@@ -682,6 +742,14 @@ void Session::buildSdp(resip::SdpContents &sdp, SdpDirection sdpDirection)
     {
         sdp.session().addAttribute("ice-pwd", resip::Data(mIceStack->localPassword()));
         sdp.session().addAttribute("ice-ufrag", resip::Data(mIceStack->localUfrag()));
+
+        // In single port mode connectivity checks from new peer addresses are routed by ufrag
+        for (Stream& stream: mStreamList)
+        {
+            for (auto* socket: {stream.socket4().mRtp.get(), stream.socket6().mRtp.get()})
+                if (VirtualDatagramSocket* v = dynamic_cast<VirtualDatagramSocket*>(socket))
+                    v->setIceUfrag(mIceStack->localUfrag());
+        }
     }
 
     // Iterate media streams
@@ -778,6 +846,7 @@ void Session::addProvider(PDataProvider provider)
         {
             streamIter->setProvider( provider );
             provider->setSocket(streamIter->socket4(), streamIter->socket6());
+            invalidateSocketRoutes();
             return;
         }
     }
@@ -804,6 +873,7 @@ void Session::addProvider(PDataProvider provider)
     s.setIceInfo(ii);
 
     mStreamList.push_back(s);
+    invalidateSocketRoutes();
 }
 
 PDataProvider Session::providerAt(int index)
@@ -896,6 +966,7 @@ void Session::refreshMediaPath()
         p->setSocket(s4, s6);
         s.setSocket4(s4);
         s.setSocket6(s6);
+        invalidateSocketRoutes();
     }
 
     // Recreate new ufrag/pwd and gather ice candidates
@@ -928,7 +999,10 @@ int Session::processSdp(uint64_t version, bool iceAvailable, std::string icePwd,
 
         // Ask about provider if needed
         if (!stream.provider())
+        {
             stream.setProvider( mUserAgent->onProviderNeeded(remoteStream.name().c_str()) );
+            invalidateSocketRoutes();
+        }
 
         // Check the stream validity
         if (!stream.provider())
@@ -981,6 +1055,7 @@ int Session::processSdp(uint64_t version, bool iceAvailable, std::string icePwd,
 
             // Update provider with socket references
             stream.provider()->setSocket(stream.socket4(), stream.socket6());
+            invalidateSocketRoutes();
         }
 
 
@@ -1006,6 +1081,7 @@ int Session::processSdp(uint64_t version, bool iceAvailable, std::string icePwd,
             if (!targetAddr.multiplexed() && !mUserAgent->mConfig[CONFIG_MULTIPLEXING].asBool())
                 ii.mComponentId.mRtcp = mIceStack->addComponent(ii.mStreamId, NULL, stream.socket4().mRtcp->localport(), stream.socket6().mRtcp->localport());
             stream.setIceInfo(ii);
+            invalidateSocketRoutes();
         }
 
         if (iceAvailable)
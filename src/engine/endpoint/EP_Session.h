@@ -72,7 +72,9 @@ enum SessionInfo
   SessionInfo_BitrateSwitchCounter, // It is for AMR codecs only
   SessionInfo_RemotePeer,
   SessionInfo_SSRC,
-  SessionInfo_CngCounter            // For AMR codecs only
+  SessionInfo_CngCounter,           // For AMR codecs only
+  SessionInfo_LocalDrops,           // packets dropped by kernel on local sockets
+  SessionInfo_FecRecovered          // lost packets recovered from in-band FEC
 };
 
 
@@ -174,7 +176,10 @@ public:
   void setUserHeaders(const UserHeaders& headers);
 
   // Called when new media data are available for this session
-  void onReceivedData(PDatagramSocket socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize);
+  void onReceivedData(PDatagramSocket socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize, DatagramTime receiveTime) override;
+
+  // Called with burst of datagrams from single media socket; the whole burst is processed under one session lock
+  void onReceivedBatch(PDatagramSocket socket, DatagramBatch& batch) override;
 
   // Called when new candidate is gathered
   void onCandidateGathered(ice::Stack* stack, void* tag, const char* address);
@@ -200,6 +205,9 @@ public:
   // Searches provider by its local port number
   PDataProvider findProviderByPort(int family, unsigned short port);
 
+  // Marks socket dispatch table outdated. Must be called when sockets, providers or ICE ids of streams change.
+  void invalidateSocketRoutes();
+
   // Add provider to internal list
   void addProvider(PDataProvider provider);
   PDataProvider providerAt(int index);
@@ -283,6 +291,21 @@ public:
    // List of turn prefixes related to sessioj
    std::vector<int>     mTurnPrefixList;
 
+   // Receive dispatch entry for media socket of stream. Filled from mStreamList on demand; looked up
+   // by socket pointer, so it works when streams share local port (single port mode).
+   struct SocketRoute
+   {
+     DatagramSocket*  mSocket = nullptr;
+     PDataProvider    mProvider;
+     int              mIceStream = -1;
+     int              mIceComponent = -1;
+   };
+   std::vector<SocketRoute> mSocketRoutes;
+   std::atomic_bool     mSocketRoutesDirty = true;
+
+   // Returns dispatch entry for socket or nullptr. mGuard must be locked.
+   const SocketRoute* findSocketRoute(DatagramSocket* socket);
+
    // True if user agent has to send offer
    bool                 mHasToSendOffer;
 
@@ -314,6 +337,10 @@ public:
    // Helper method to find audio provider for active sip stream
    AudioProvider* findProviderForActiveAudio();
 
+   // Routes single received datagram to ICE stack or media provider. mGuard must be locked.
+   void processReceivedData(const PDatagramSocket& socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize, DatagramTime receiveTime);
+
+
    void processCommandList();
    void addCommand(Command* cmd);
    void enqueueOffer();
@@ -55,6 +55,17 @@
 #define RTP_BUFFER_LOW       (0)
 #define RTP_BUFFER_PREBUFFER (100)
 
+// Initial and maximal number of slots in jitter buffer ring (powers of two). Ring is indexed by
+// extended sequence number, so maximal size limits distance between oldest and newest buffered packet.
+#define RTP_BUFFER_RING_SIZE     (64)
+#define RTP_BUFFER_RING_MAX_SIZE (32768)
+
+// Adaptive playout: number of recent packets used to estimate arrival delay spread,
+// maximal target delay and minimal jitter buffer high-water mark (milliseconds)
+#define RTP_BUFFER_ADAPTIVE_WINDOW (256)
+#define RTP_BUFFER_ADAPTIVE_MAX    (500)
+#define RTP_BUFFER_ADAPTIVE_HIGH   (240)
+
 #define RTP_DECODED_CAPACITY 2048
 
 #define DEFAULT_SUBSCRIPTION_TIME 1200
@@ -66,6 +77,12 @@
 #define MAX_UDPPACKET_SIZE 65535
 #define MAX_VALID_UDPPACKET_SIZE 2048
 
+// Maximum number of datagrams read from single socket per reactor wakeup
+#define MAX_RECV_BATCH 16
+
+// Maximum number of datagrams queued for sending during single media tick
+#define MAX_SEND_BATCH 64
+
 // AMR codec defines - it requires USE_AMR_CODEC defined
 // #define USE_AMR_CODEC
 #define MT_AMRNB_PAYLOADTYPE 112
@@ -114,4 +131,13 @@
 // Number of samples
 #define MT_MAX_DECODEBUFFER  32768
 
+// Maximal number of consecutive RTP packets AudioReceiver decodes with single Codec::decodeBatch() call
+#define MT_MAX_DECODEBATCH 32
+
+// Number of idle codec library states (per state type) kept for reuse by new streams
+#define MT_CODEC_STATE_POOL_SIZE 32
+
+// Number of received RTP packets AudioStream can hold between network and playout threads (power of two)
+#define MT_RECEIVE_QUEUE_SIZE 512
+
 #endif
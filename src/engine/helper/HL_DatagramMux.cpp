@@ -0,0 +1,350 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "HL_DatagramMux.h"
+#include "HL_SocketHeap.h"
+#include "HL_Rtp.h"
+#include "HL_Log.h"
+
+#include <algorithm>
+
+#define LOG_SUBSYSTEM "network"
+
+// STUN USERNAME attribute type (RFC 5389)
+#define STUN_ATTR_USERNAME 0x0006
+
+// Extracts local part of ICE USERNAME ("local:remote") from STUN message. Returns empty string if there is no USERNAME.
+static std::string findStunUfrag(const uint8_t* data, unsigned size)
+{
+    // STUN message starts with two zero bits
+    if (size < 20 || (data[0] & 0xC0) != 0)
+        return std::string();
+
+    unsigned length = (data[2] << 8) | data[3];
+    unsigned end = std::min(size, 20 + length);
+    unsigned offset = 20;
+    while (offset + 4 <= end)
+    {
+        unsigned type = (data[offset] << 8) | data[offset + 1];
+        unsigned attrLength = (data[offset + 2] << 8) | data[offset + 3];
+        offset += 4;
+        if (offset + attrLength > end)
+            break;
+
+        if (type == STUN_ATTR_USERNAME)
+        {
+            std::string username(reinterpret_cast<const char*>(data + offset), attrLength);
+            return username.substr(0, username.find(':'));
+        }
+
+        // Attributes are padded to 4 bytes
+        offset += (attrLength + 3) & ~3u;
+    }
+    return std::string();
+}
+
+// ------------------------ VirtualDatagramSocket ---------------------
+VirtualDatagramSocket::VirtualDatagramSocket(DatagramMux& mux, const PDatagramSocket& carrier, SocketSink* sink)
+    :mMux(&mux), mCarrier(carrier), mSink(sink)
+{
+    mFamily = carrier->family();
+    mLocalPort = carrier->localport();
+}
+
+VirtualDatagramSocket::~VirtualDatagramSocket()
+{
+    closeSocket();
+}
+
+int VirtualDatagramSocket::localport()
+{
+    return mLocalPort;
+}
+
+void VirtualDatagramSocket::sendDatagram(InternetAddress& dest, const void* packetData, unsigned packetSize)
+{
+    if (mClosed)
+        return;
+
+    willSendTo(dest);
+    mCarrier->sendDatagram(dest, packetData, packetSize);
+}
+
+unsigned VirtualDatagramSocket::recvDatagram(InternetAddress& /*src*/, void* /*packetBuffer*/, unsigned /*packetCapacity*/)
+{
+    // Data is pushed by DatagramMux
+    return 0;
+}
+
+unsigned VirtualDatagramSocket::recvDatagrams(DatagramBatch& batch)
+{
+    batch.clear();
+    return 0;
+}
+
+void VirtualDatagramSocket::closeSocket()
+{
+    if (!mClosed)
+    {
+        mClosed = true;
+        mMux->unregister(this);
+    }
+}
+
+bool VirtualDatagramSocket::isValid() const
+{
+    return !mClosed && mCarrier->isValid();
+}
+
+int VirtualDatagramSocket::family() const
+{
+    return mFamily;
+}
+
+bool VirtualDatagramSocket::setBlocking(bool /*blocking*/)
+{
+    return true;
+}
+
+SOCKET VirtualDatagramSocket::socket() const
+{
+    // Batched senders write to carrier directly
+    return mClosed ? INVALID_SOCKET : mCarrier->socket();
+}
+
+void VirtualDatagramSocket::willSendTo(const InternetAddress& dest)
+{
+    // Most of time destination does not change - avoid taking mux lock per packet
+    if (mClosed || dest == mLastDestination)
+        return;
+
+    mMux->learnAddress(this, dest);
+}
+
+void VirtualDatagramSocket::addSsrc(uint32_t ssrc)
+{
+    if (!mClosed)
+        mMux->learnSsrc(this, ssrc);
+}
+
+void VirtualDatagramSocket::setIceUfrag(const std::string& ufrag)
+{
+    if (!mClosed)
+        mMux->learnUfrag(this, ufrag);
+}
+
+// ----------------------------- DatagramMux --------------------------
+DatagramMux::DatagramMux()
+{}
+
+DatagramMux::~DatagramMux()
+{}
+
+void DatagramMux::addCarrier(const PDatagramSocket& carrier)
+{
+    Lock l(mGuard);
+    mCarriers.push_back(carrier);
+}
+
+bool DatagramMux::hasCarrier(int family)
+{
+    Lock l(mGuard);
+    return std::any_of(mCarriers.begin(), mCarriers.end(), [family](const PDatagramSocket& s) { return s->family() == family; });
+}
+
+std::vector<PDatagramSocket> DatagramMux::clear()
+{
+    Lock l(mGuard);
+    for (auto& item: mByAddress)
+        item.second->mAddresses.clear();
+    mByAddress.clear();
+    mBySsrc.clear();
+    mByUfrag.clear();
+
+    std::vector<PDatagramSocket> result;
+    result.swap(mCarriers);
+    return result;
+}
+
+PDatagramSocket DatagramMux::createSocket(int family, SocketSink* sink)
+{
+    Lock l(mGuard);
+
+    // Sending goes via first carrier of family - all of them share the same local port
+    for (auto& carrier: mCarriers)
+    {
+        if (carrier->family() == family)
+            return std::make_shared<VirtualDatagramSocket>(*this, carrier, sink);
+    }
+    return PDatagramSocket();
+}
+
+size_t DatagramMux::unroutedCount() const
+{
+    Lock l(mGuard);
+    return mUnrouted;
+}
+
+void DatagramMux::learnAddress(VirtualDatagramSocket* s, const InternetAddress& address)
+{
+    Lock l(mGuard);
+    s->mLastDestination = address;
+
+    auto iter = mByAddress.find(address);
+    if (iter != mByAddress.end())
+    {
+        if (iter->second == s)
+            return;
+
+        // Address moved to another stream (e.g. previous call from the same peer is over)
+        auto& previous = iter->second->mAddresses;
+        previous.erase(std::remove(previous.begin(), previous.end(), address), previous.end());
+        iter->second = s;
+    }
+    else
+        mByAddress[address] = s;
+    s->mAddresses.push_back(address);
+}
+
+void DatagramMux::learnSsrc(VirtualDatagramSocket* s, uint32_t ssrc)
+{
+    Lock l(mGuard);
+    if (std::find(s->mSsrcs.begin(), s->mSsrcs.end(), ssrc) != s->mSsrcs.end())
+        return;
+
+    VirtualDatagramSocket*& owner = mBySsrc[ssrc];
+    if (owner && owner != s)
+        owner->mSsrcs.erase(std::remove(owner->mSsrcs.begin(), owner->mSsrcs.end(), ssrc), owner->mSsrcs.end());
+    owner = s;
+    s->mSsrcs.push_back(ssrc);
+}
+
+void DatagramMux::learnUfrag(VirtualDatagramSocket* s, const std::string& ufrag)
+{
+    Lock l(mGuard);
+    if (s->mUfrag == ufrag)
+        return;
+
+    if (!s->mUfrag.empty())
+    {
+        auto iter = mByUfrag.find(s->mUfrag);
+        if (iter != mByUfrag.end() && iter->second == s)
+            mByUfrag.erase(iter);
+    }
+    s->mUfrag = ufrag;
+
+    // Streams of one session share ufrag - the first one keeps it
+    if (!ufrag.empty())
+        mByUfrag.insert(std::make_pair(ufrag, s));
+}
+
+void DatagramMux::unregister(VirtualDatagramSocket* s)
+{
+    Lock l(mGuard);
+    for (auto& address: s->mAddresses)
+    {
+        auto iter = mByAddress.find(address);
+        if (iter != mByAddress.end() && iter->second == s)
+            mByAddress.erase(iter);
+    }
+    s->mAddresses.clear();
+
+    for (uint32_t ssrc: s->mSsrcs)
+    {
+        auto iter = mBySsrc.find(ssrc);
+        if (iter != mBySsrc.end() && iter->second == s)
+            mBySsrc.erase(iter);
+    }
+    s->mSsrcs.clear();
+
+    if (!s->mUfrag.empty())
+    {
+        auto iter = mByUfrag.find(s->mUfrag);
+        if (iter != mByUfrag.end() && iter->second == s)
+            mByUfrag.erase(iter);
+        s->mUfrag.clear();
+    }
+}
+
+VirtualDatagramSocket* DatagramMux::route(const InternetAddress& src, const uint8_t* data, unsigned size)
+{
+    VirtualDatagramSocket* result = nullptr;
+    auto addressIter = mByAddress.find(src);
+    if (addressIter != mByAddress.end())
+        result = addressIter->second;
+    else
+    if (size > 0 && data[0] < 4)
+    {
+        // STUN - connectivity check from peer address which was not used yet
+        std::string ufrag = findStunUfrag(data, size);
+        auto iter = ufrag.empty() ? mByUfrag.end() : mByUfrag.find(ufrag);
+        if (iter != mByUfrag.end())
+            result = iter->second;
+    }
+    else
+    if (RtpHelper::isRtpOrRtcp(data, size))
+    {
+        // Peer moved to another address (NAT rebinding) - find it by SSRC
+        auto iter = mBySsrc.find(RtpHelper::findSsrc(data, size));
+        if (iter != mBySsrc.end())
+            result = iter->second;
+    }
+
+    if (!result)
+        return nullptr;
+
+    if (addressIter == mByAddress.end())
+    {
+        mByAddress[src] = result;
+        result->mAddresses.push_back(src);
+    }
+
+    // Remember SSRC of routed media - it is the key if peer address changes later
+    if (RtpHelper::isRtp(data, size))
+    {
+        uint32_t ssrc = RtpHelper::findSsrc(data, size);
+        if (std::find(result->mSsrcs.begin(), result->mSsrcs.end(), ssrc) == result->mSsrcs.end())
+        {
+            VirtualDatagramSocket*& owner = mBySsrc[ssrc];
+            if (!owner)
+            {
+                owner = result;
+                result->mSsrcs.push_back(ssrc);
+            }
+        }
+    }
+    return result;
+}
+
+void DatagramMux::onReceivedData(PDatagramSocket socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize, DatagramTime receiveTime)
+{
+    PDatagramSocket target;
+    SocketSink* sink = nullptr;
+    {
+        Lock l(mGuard);
+        VirtualDatagramSocket* s = route(src, reinterpret_cast<const uint8_t*>(receivedPtr), receivedSize);
+        if (s)
+        {
+            // Socket can be in destruction already - it is unregistered then soon
+            target = s->weak_from_this().lock();
+            sink = s->mSink;
+        }
+        if (!target)
+        {
+            mUnrouted++;
+            return;
+        }
+    }
+
+    // Sink is called without mux lock - it can send data (and so learn addresses) from the callback
+    sink->onReceivedData(target, src, receivedPtr, receivedSize, receiveTime);
+}
+
+void DatagramMux::onReceivedBatch(PDatagramSocket socket, DatagramBatch& batch)
+{
+    // Datagrams of burst belong to different streams as a rule - route them one by one
+    for (unsigned i=0; i<batch.count(); i++)
+        onReceivedData(socket, batch.sourceAt(i), batch.dataAt(i), batch.sizeAt(i), batch.timeAt(i));
+}
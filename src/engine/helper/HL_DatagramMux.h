@@ -0,0 +1,105 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __HL_DATAGRAM_MUX_H
+#define __HL_DATAGRAM_MUX_H
+
+#include "../engine_config.h"
+#include "HL_NetworkSocket.h"
+#include "HL_Sync.h"
+#include "HL_SocketHeap.h"
+
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <memory>
+
+class DatagramMux;
+
+// Socket handed to media stream in single port mode. It has no own handle - datagrams are sent
+// via carrier socket shared with other streams and received data is routed to it by DatagramMux.
+class VirtualDatagramSocket: public DatagramSocket, public std::enable_shared_from_this<VirtualDatagramSocket>
+{
+    friend class DatagramMux;
+public:
+    VirtualDatagramSocket(DatagramMux& mux, const PDatagramSocket& carrier, SocketSink* sink);
+    ~VirtualDatagramSocket();
+
+    int       localport() override;
+    void      sendDatagram(InternetAddress& dest, const void* packetData, unsigned packetSize) override;
+    unsigned  recvDatagram(InternetAddress& src, void* packetBuffer, unsigned packetCapacity) override;
+    unsigned  recvDatagrams(DatagramBatch& batch) override;
+    void      closeSocket() override;
+    bool      isValid() const override;
+    int       family() const override;
+    bool      setBlocking(bool blocking) override;
+    SOCKET    socket() const override;
+    void      willSendTo(const InternetAddress& dest) override;
+
+    // Fallback routing keys for packets coming from unknown addresses
+    void      addSsrc(uint32_t ssrc);
+    void      setIceUfrag(const std::string& ufrag);
+
+protected:
+    DatagramMux*    mMux;
+    PDatagramSocket mCarrier;
+    SocketSink*     mSink;
+    bool            mClosed = false;
+
+    // Routing keys owned by this socket; guarded by DatagramMux lock
+    InternetAddress mLastDestination;
+    std::vector<InternetAddress> mAddresses;
+    std::vector<uint32_t> mSsrcs;
+    std::string mUfrag;
+};
+typedef std::shared_ptr<VirtualDatagramSocket> PVirtualDatagramSocket;
+
+// Receives datagrams from carrier sockets bound to single media port and routes them to virtual sockets.
+// Routing key is remote transport address; it is learned when virtual socket sends data to peer.
+// Packets from unknown addresses are matched by ICE ufrag (STUN USERNAME) or RTP/RTCP SSRC,
+// the new remote address is learned then.
+class DatagramMux: public SocketSink
+{
+public:
+    DatagramMux();
+    ~DatagramMux();
+
+    // Adds carrier socket. Several carriers of one family share port via SO_REUSEPORT.
+    void addCarrier(const PDatagramSocket& carrier);
+    bool hasCarrier(int family);
+
+    // Returns carriers and forgets them together with all routes
+    std::vector<PDatagramSocket> clear();
+
+    // Creates virtual socket for sink; returns nullptr if there is no carrier for family
+    PDatagramSocket createSocket(int family, SocketSink* sink);
+
+    // Number of datagrams dropped as not belonging to any virtual socket
+    size_t unroutedCount() const;
+
+    void onReceivedData(PDatagramSocket socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize, DatagramTime receiveTime) override;
+    void onReceivedBatch(PDatagramSocket socket, DatagramBatch& batch) override;
+
+protected:
+    friend class VirtualDatagramSocket;
+
+    mutable Mutex mGuard;
+    std::vector<PDatagramSocket> mCarriers;
+    std::map<InternetAddress, VirtualDatagramSocket*> mByAddress;
+    std::unordered_map<uint32_t, VirtualDatagramSocket*> mBySsrc;
+    std::unordered_map<std::string, VirtualDatagramSocket*> mByUfrag;
+    size_t mUnrouted = 0;
+
+    void learnAddress(VirtualDatagramSocket* s, const InternetAddress& address);
+    void learnSsrc(VirtualDatagramSocket* s, uint32_t ssrc);
+    void learnUfrag(VirtualDatagramSocket* s, const std::string& ufrag);
+    void unregister(VirtualDatagramSocket* s);
+
+    // Finds virtual socket for datagram. mGuard must be locked.
+    VirtualDatagramSocket* route(const InternetAddress& src, const uint8_t* data, unsigned size);
+};
+
+#endif
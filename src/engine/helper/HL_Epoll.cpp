@@ -0,0 +1,106 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "HL_Epoll.h"
+
+#if defined(HAVE_EPOLL)
+
+#include "HL_Log.h"
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#define LOG_SUBSYSTEM "network"
+
+// Maximum number of events returned by single epoll_wait() call
+#define EPOLL_MAX_EVENTS 256
+
+Epoll::Epoll()
+{
+    mEvents.resize(EPOLL_MAX_EVENTS);
+}
+
+Epoll::~Epoll()
+{
+    close();
+}
+
+bool Epoll::open()
+{
+    if (mHandle != -1)
+        return true;
+
+    mHandle = ::epoll_create1(EPOLL_CLOEXEC);
+    if (mHandle == -1)
+    {
+        ICELogError(<< "epoll_create1() failed, error " << errno);
+        return false;
+    }
+    return true;
+}
+
+void Epoll::close()
+{
+    if (mHandle != -1)
+    {
+        ::close(mHandle);
+        mHandle = -1;
+    }
+}
+
+bool Epoll::isOpened() const
+{
+    return mHandle != -1;
+}
+
+bool Epoll::add(SOCKET s)
+{
+    if (mHandle == -1 || s == INVALID_SOCKET)
+        return false;
+
+    epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN;
+    ev.data.fd = s;
+    if (::epoll_ctl(mHandle, EPOLL_CTL_ADD, s, &ev) != 0)
+    {
+        ICELogError(<< "Failed to add socket " << s << " to epoll set, error " << errno);
+        return false;
+    }
+    return true;
+}
+
+void Epoll::remove(SOCKET s)
+{
+    if (mHandle == -1 || s == INVALID_SOCKET)
+        return;
+
+    // Kernels before 2.6.9 require non-null event pointer even for EPOLL_CTL_DEL
+    epoll_event ev;
+    memset(&ev, 0, sizeof ev);
+    ::epoll_ctl(mHandle, EPOLL_CTL_DEL, s, &ev);
+}
+
+int Epoll::wait(std::chrono::milliseconds timeout)
+{
+    if (mHandle == -1)
+        return 0;
+
+    int rescode = ::epoll_wait(mHandle, mEvents.data(), static_cast<int>(mEvents.size()), static_cast<int>(timeout.count()));
+    if (rescode < 0)
+    {
+        if (errno != EINTR)
+            ICELogError(<< "epoll_wait() failed, error " << errno);
+        return 0;
+    }
+    return rescode;
+}
+
+SOCKET Epoll::readyAt(int index) const
+{
+    return mEvents[static_cast<size_t>(index)].data.fd;
+}
+
+#endif
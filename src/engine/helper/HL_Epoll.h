@@ -0,0 +1,55 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __HL_EPOLL_H
+#define __HL_EPOLL_H
+
+#include "../engine_config.h"
+#include "HL_InternetAddress.h"
+
+#include <vector>
+#include <chrono>
+
+#if defined(TARGET_LINUX) || defined(TARGET_ANDROID)
+# define HAVE_EPOLL
+#endif
+
+#if defined(HAVE_EPOLL)
+# include <sys/epoll.h>
+
+// Thin wrapper around Linux epoll instance. Sockets are registered once and stay in the
+// kernel interest list until removed, so waiting does not depend on total number of sockets.
+// Registration (add/remove) is safe to call from other threads while wait() is in progress.
+class Epoll
+{
+public:
+    Epoll();
+    ~Epoll();
+
+    // Creates epoll instance; returns false if kernel refused it
+    bool open();
+    void close();
+    bool isOpened() const;
+
+    // Starts watching socket for incoming data (level triggered). Returns false on failure.
+    bool add(SOCKET s);
+
+    // Stops watching socket. Must be called before socket is closed.
+    void remove(SOCKET s);
+
+    // Waits for readable sockets. Returns number of ready sockets (0 on timeout or error).
+    int wait(std::chrono::milliseconds timeout);
+
+    // Returns ready socket at index [0..wait() result)
+    SOCKET readyAt(int index) const;
+
+protected:
+    int mHandle = -1;
+    std::vector<epoll_event> mEvents;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,339 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "HL_IoUring.h"
+
+#if defined(HAVE_IO_URING)
+
+#include "HL_Log.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <string.h>
+
+#define LOG_SUBSYSTEM "network"
+
+// Provided buffer group used for receive buffers
+#define IO_URING_BUFFER_GROUP 0
+
+// user_data of cancel requests; their completions are not reported to handler
+#define IO_URING_CANCEL_TAG UINT64_MAX
+
+static int ioUringSetup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+IoUring::IoUring()
+{
+    memset(&mMsgTemplate, 0, sizeof mMsgTemplate);
+}
+
+IoUring::~IoUring()
+{
+    close();
+}
+
+bool IoUring::open(unsigned entries, unsigned bufferCount, unsigned packetSize)
+{
+    if (mHandle != -1)
+        return true;
+
+    // Buffer ring size must be power of two
+    if (!bufferCount || (bufferCount & (bufferCount - 1)) || bufferCount > 32768)
+        return false;
+
+    io_uring_params params;
+    memset(&params, 0, sizeof params);
+
+    // Every multishot receive produces completion per datagram - give completions more room
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    mHandle = ioUringSetup(entries, &params);
+    if (mHandle < 0)
+    {
+        ICELogInfo(<< "io_uring is not available, error " << errno);
+        mHandle = -1;
+        return false;
+    }
+
+    // Timed wait and single mapping of both rings are needed below
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        ICELogInfo(<< "io_uring lacks required features, using epoll");
+        close();
+        return false;
+    }
+
+    mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (mCqRingSize > mSqRingSize)
+        mSqRingSize = mCqRingSize;
+
+    mSqRing = ::mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mHandle, IORING_OFF_SQ_RING);
+    if (mSqRing == MAP_FAILED)
+    {
+        mSqRing = nullptr;
+        close();
+        return false;
+    }
+    mCqRing = mSqRing;
+
+    mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mHandle, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    mSqes = static_cast<io_uring_sqe*>(sqes);
+
+    uint8_t* sq = static_cast<uint8_t*>(mSqRing);
+    mSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    mSqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    mSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    mSqLocalTail = *mSqTail;
+
+    uint8_t* cq = static_cast<uint8_t*>(mCqRing);
+    mCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    mCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    mCqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    mCqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Receive buffers: recvmsg header + source address + ancillary data + payload
+    mMsgTemplate.msg_namelen = sizeof(sockaddr_storage);
+    mMsgTemplate.msg_controllen = DATAGRAM_CONTROL_SIZE;
+    mBufCount = bufferCount;
+    mBufSize = sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_storage) + DATAGRAM_CONTROL_SIZE + packetSize;
+    mBuffers.resize(size_t(mBufCount) * mBufSize);
+
+    mBufRingSize = mBufCount * sizeof(io_uring_buf);
+    void* bufRing = ::mmap(nullptr, mBufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufRing == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    mBufRing = static_cast<io_uring_buf_ring*>(bufRing);
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof reg);
+    reg.ring_addr = reinterpret_cast<uint64_t>(mBufRing);
+    reg.ring_entries = mBufCount;
+    reg.bgid = IO_URING_BUFFER_GROUP;
+    if (ioUringRegister(mHandle, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        // Kernels before 5.19
+        ICELogInfo(<< "io_uring provided buffer rings are not supported, error " << errno);
+        close();
+        return false;
+    }
+
+    mBufTail = 0;
+    for (unsigned i=0; i<mBufCount; i++)
+        recycleBuffer(i);
+
+    return true;
+}
+
+void IoUring::close()
+{
+    if (mBufRing)
+    {
+        ::munmap(mBufRing, mBufRingSize);
+        mBufRing = nullptr;
+    }
+    if (mSqes)
+    {
+        ::munmap(mSqes, mSqesSize);
+        mSqes = nullptr;
+    }
+    if (mSqRing)
+    {
+        ::munmap(mSqRing, mSqRingSize);
+        mSqRing = mCqRing = nullptr;
+    }
+    if (mHandle != -1)
+    {
+        ::close(mHandle);
+        mHandle = -1;
+    }
+    mBuffers.clear();
+    mSqPending = 0;
+}
+
+bool IoUring::isOpened() const
+{
+    return mHandle != -1;
+}
+
+io_uring_sqe* IoUring::getSqe()
+{
+    // Queue is full - push pending entries to kernel first
+    if (mSqPending > mSqMask)
+        submit();
+    if (mSqPending > mSqMask)
+        return nullptr;
+
+    unsigned index = mSqLocalTail & mSqMask;
+    io_uring_sqe* sqe = &mSqes[index];
+    memset(sqe, 0, sizeof *sqe);
+    mSqArray[index] = index;
+    mSqLocalTail++;
+    mSqPending++;
+    return sqe;
+}
+
+bool IoUring::recvMultishot(SOCKET s, uint64_t tag)
+{
+    if (mHandle == -1)
+        return false;
+
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = s;
+    sqe->addr = reinterpret_cast<uint64_t>(&mMsgTemplate);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = IO_URING_BUFFER_GROUP;
+    sqe->user_data = tag;
+    return true;
+}
+
+void IoUring::cancel(SOCKET s)
+{
+    if (mHandle == -1)
+        return;
+
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = s;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = IO_URING_CANCEL_TAG;
+
+    // Cancellation looks the descriptor up on submission, so it must happen before socket is closed
+    submit();
+}
+
+void IoUring::submit()
+{
+    if (mHandle == -1 || !mSqPending)
+        return;
+
+    __atomic_store_n(mSqTail, mSqLocalTail, __ATOMIC_RELEASE);
+    int submitted = enter(mSqPending, 0, 0, nullptr, 0);
+    if (submitted > 0)
+        mSqPending -= static_cast<unsigned>(submitted) < mSqPending ? static_cast<unsigned>(submitted) : mSqPending;
+}
+
+int IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize)
+{
+    int rescode = static_cast<int>(::syscall(__NR_io_uring_enter, mHandle, toSubmit, minComplete, flags, arg, argSize));
+    return rescode < 0 ? -errno : rescode;
+}
+
+void IoUring::recycleBuffer(unsigned id)
+{
+    // Entries are addressed directly: in C++ the header's flexible array member does not start at offset 0
+    io_uring_buf& b = reinterpret_cast<io_uring_buf*>(mBufRing)[mBufTail & (mBufCount - 1)];
+    b.addr = reinterpret_cast<uint64_t>(mBuffers.data() + size_t(id) * mBufSize);
+    b.len = mBufSize;
+    b.bid = static_cast<uint16_t>(id);
+    mBufTail++;
+    __atomic_store_n(&mBufRing->tail, static_cast<uint16_t>(mBufTail), __ATOMIC_RELEASE);
+}
+
+bool IoUring::wait(std::chrono::milliseconds timeout)
+{
+    if (mHandle == -1)
+        return false;
+
+    __kernel_timespec ts;
+    ts.tv_sec = timeout.count() / 1000;
+    ts.tv_nsec = (timeout.count() % 1000) * 1000000;
+
+    io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof arg);
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+
+    __atomic_store_n(mSqTail, mSqLocalTail, __ATOMIC_RELEASE);
+    int rescode = enter(mSqPending, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+    if (rescode >= 0)
+        mSqPending -= static_cast<unsigned>(rescode) < mSqPending ? static_cast<unsigned>(rescode) : mSqPending;
+    else
+    if (rescode != -ETIME && rescode != -EINTR && rescode != -EBUSY)
+    {
+        ICELogError(<< "io_uring_enter() failed, error " << -rescode);
+        return false;
+    }
+    return true;
+}
+
+int IoUring::reap(Handler& handler)
+{
+    if (mHandle == -1)
+        return 0;
+
+    int processed = 0;
+    unsigned head = *mCqHead;
+    unsigned tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++, processed++)
+    {
+        const io_uring_cqe& cqe = mCqes[head & mCqMask];
+        if (cqe.user_data == IO_URING_CANCEL_TAG)
+            continue;
+
+        if (cqe.res >= 0 && (cqe.flags & IORING_CQE_F_BUFFER))
+        {
+            unsigned id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+            uint8_t* buffer = mBuffers.data() + size_t(id) * mBufSize;
+            const io_uring_recvmsg_out* out = reinterpret_cast<const io_uring_recvmsg_out*>(buffer);
+
+            // Layout is fixed by template lengths: header, name, control, payload
+            uint8_t* name = buffer + sizeof(io_uring_recvmsg_out);
+            uint8_t* control = name + mMsgTemplate.msg_namelen;
+            uint8_t* payload = control + mMsgTemplate.msg_controllen;
+            unsigned available = static_cast<unsigned>(buffer + cqe.res - payload);
+
+            Datagram d;
+            memset(&d.mHeader, 0, sizeof d.mHeader);
+            d.mTag = cqe.user_data;
+            d.mData = payload;
+            d.mSize = out->payloadlen < available ? out->payloadlen : available;
+            d.mTruncated = (out->flags & MSG_TRUNC) || out->payloadlen > available;
+            d.mHeader.msg_name = name;
+            d.mHeader.msg_namelen = out->namelen < mMsgTemplate.msg_namelen ? out->namelen : mMsgTemplate.msg_namelen;
+            d.mHeader.msg_control = control;
+            d.mHeader.msg_controllen = out->controllen < mMsgTemplate.msg_controllen ? out->controllen : mMsgTemplate.msg_controllen;
+            handler.onDatagram(d);
+
+            recycleBuffer(id);
+        }
+
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+            handler.onReceiveStopped(cqe.user_data, cqe.res < 0 ? cqe.res : 0);
+    }
+    __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+
+    return processed;
+}
+
+#endif
@@ -0,0 +1,118 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __HL_IO_URING_H
+#define __HL_IO_URING_H
+
+#include "../engine_config.h"
+#include "HL_NetworkSocket.h"
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#if defined(USE_IO_URING) && defined(TARGET_LINUX) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#  define HAVE_IO_URING
+# endif
+#endif
+
+#if defined(HAVE_IO_URING)
+# include <linux/io_uring.h>
+
+// Minimal io_uring instance used by SocketHeap reactor (no liburing dependency - raw syscalls).
+// Sockets are armed with multishot recvmsg: one submission keeps delivering datagrams into
+// buffers taken from the provided-buffer ring until it is cancelled, so receiving costs
+// neither per-packet syscall nor per-socket readiness wakeup.
+// Requires kernel 6.0+; open() fails on older kernels and caller falls back to epoll.
+// All methods except open()/close() must be called from single (reactor) thread.
+class IoUring
+{
+public:
+    // Datagram delivered by multishot receive. Pointers are valid until handler returns.
+    struct Datagram
+    {
+        uint64_t        mTag = 0;           // Tag passed to recvMultishot()
+        const uint8_t*  mData = nullptr;
+        unsigned        mSize = 0;
+        bool            mTruncated = false; // Datagram did not fit into buffer
+        msghdr          mHeader;            // Source address and ancillary data (msg_name / msg_control)
+    };
+
+    class Handler
+    {
+    public:
+        virtual ~Handler() {}
+        virtual void onDatagram(const Datagram& d) = 0;
+
+        // Multishot receive for tag finished - socket has to be armed again unless it is removed.
+        // 'error' is negative errno; -ENOBUFS means buffer ring was exhausted.
+        virtual void onReceiveStopped(uint64_t tag, int error) = 0;
+    };
+
+    IoUring();
+    ~IoUring();
+
+    // Creates ring and registers 'bufferCount' (power of two) receive buffers. Returns false if kernel refused it.
+    bool open(unsigned entries = 256, unsigned bufferCount = 1024, unsigned packetSize = MAX_VALID_UDPPACKET_SIZE);
+    void close();
+    bool isOpened() const;
+
+    // Queues multishot recvmsg for socket. Submitted by next wait() or submit().
+    bool recvMultishot(SOCKET s, uint64_t tag);
+
+    // Cancels all requests for socket and submits immediately - socket can be closed right after return
+    void cancel(SOCKET s);
+
+    // Submits queued requests
+    void submit();
+
+    // Submits queued requests and waits for completions up to timeout. Returns false on ring failure.
+    bool wait(std::chrono::milliseconds timeout);
+
+    // Reports ready completions to handler. Returns number of processed completions.
+    int reap(Handler& handler);
+
+protected:
+    int mHandle = -1;
+
+    // Submission queue
+    void*       mSqRing = nullptr;
+    size_t      mSqRingSize = 0;
+    unsigned*   mSqTail = nullptr;
+    unsigned    mSqMask = 0;
+    unsigned*   mSqArray = nullptr;
+    io_uring_sqe* mSqes = nullptr;
+    size_t      mSqesSize = 0;
+    unsigned    mSqLocalTail = 0;
+    unsigned    mSqPending = 0;
+
+    // Completion queue; shares mapping with submission queue when kernel supports single mmap
+    void*       mCqRing = nullptr;
+    size_t      mCqRingSize = 0;
+    unsigned*   mCqHead = nullptr;
+    unsigned*   mCqTail = nullptr;
+    unsigned    mCqMask = 0;
+    io_uring_cqe* mCqes = nullptr;
+
+    // Provided buffers
+    io_uring_buf_ring* mBufRing = nullptr;
+    size_t      mBufRingSize = 0;
+    unsigned    mBufCount = 0;
+    unsigned    mBufSize = 0;
+    unsigned    mBufTail = 0;
+    std::vector<uint8_t> mBuffers;
+
+    // Template for multishot recvmsg: only name / control lengths are used by kernel
+    msghdr      mMsgTemplate;
+
+    io_uring_sqe* getSqe();
+    void recycleBuffer(unsigned id);
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize);
+};
+
+#endif
+
+#endif
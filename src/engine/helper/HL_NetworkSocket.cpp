@@ -18,6 +18,21 @@
 #if !defined(TARGET_WIN)
 # include <unistd.h>
 #endif
+#if defined(HAVE_SENDMMSG)
+# include <netinet/in.h>
+# include <netinet/udp.h>
+# include <atomic>
+# ifndef SOL_UDP
+#  define SOL_UDP 17
+# endif
+# ifndef UDP_SEGMENT
+#  define UDP_SEGMENT 103
+# endif
+// Kernel limit for number of segments in single GSO message
+# define UDP_MAX_SEGMENTS 64
+// Whole GSO message is single UDP datagram for the kernel - its payload may not exceed 65507 bytes
+# define UDP_MAX_GSO_BYTES 65507
+#endif
 #include <assert.h>
 
 #define LOG_SUBSYSTEM "network"
@@ -93,6 +108,105 @@ unsigned DatagramSocket::recvDatagram(InternetAddress &src, void *packetBuffer,
     return 0;
 }
 
+unsigned DatagramSocket::recvDatagrams(DatagramBatch& batch)
+{
+    batch.mCount = 0;
+    batch.mDrops = 0;
+    if (mHandle == INVALID_SOCKET)
+        return 0;
+
+#if defined(HAVE_RECVMMSG)
+    // Headers must be reinitialized - kernel overwrites lengths on every call
+    for (unsigned i=0; i<batch.mCapacity; i++)
+    {
+        batch.mVectors[i].iov_base = batch.mBuffer.data() + i * batch.mPacketSize;
+        batch.mVectors[i].iov_len = batch.mPacketSize;
+
+        msghdr& h = batch.mHeaders[i].msg_hdr;
+        memset(&h, 0, sizeof h);
+        h.msg_name = &batch.mAddresses[i];
+        h.msg_namelen = sizeof(sockaddr_storage);
+        h.msg_iov = &batch.mVectors[i];
+        h.msg_iovlen = 1;
+        h.msg_control = batch.mControl.data() + i * DATAGRAM_CONTROL_SIZE;
+        h.msg_controllen = DATAGRAM_CONTROL_SIZE;
+        batch.mHeaders[i].msg_len = 0;
+    }
+
+    int received = ::recvmmsg(mHandle, batch.mHeaders.data(), batch.mCapacity, MSG_DONTWAIT, nullptr);
+    if (received <= 0)
+        return 0;
+
+    DatagramTime now = std::chrono::system_clock::now();
+
+    for (int i=0; i<received; i++)
+    {
+        const mmsghdr& h = batch.mHeaders[i];
+        if (h.msg_hdr.msg_flags & MSG_TRUNC || !h.msg_len)
+            continue;
+
+        // Compact accepted datagrams to the head of batch
+        if (batch.mCount != (unsigned)i)
+            memmove(batch.mBuffer.data() + batch.mCount * batch.mPacketSize, batch.mBuffer.data() + i * batch.mPacketSize, h.msg_len);
+        batch.mSizes[batch.mCount] = h.msg_len;
+        batch.mSources[batch.mCount] = InternetAddress(*reinterpret_cast<const sockaddr*>(&batch.mAddresses[i]), h.msg_hdr.msg_namelen);
+
+        // Kernel timestamp and drop counter; they are absent when not enabled for socket
+        batch.mTimes[batch.mCount] = parseControl(h.msg_hdr, now, batch.mDrops);
+        batch.mCount++;
+    }
+#else
+    while (batch.mCount < batch.mCapacity)
+    {
+        uint8_t* buffer = batch.mBuffer.data() + batch.mCount * batch.mPacketSize;
+        unsigned received = recvDatagram(batch.mSources[batch.mCount], buffer, batch.mPacketSize);
+        if (!received)
+            break;
+        batch.mTimes[batch.mCount] = std::chrono::system_clock::now();
+        batch.mSizes[batch.mCount++] = received;
+    }
+#endif
+    return batch.mCount;
+}
+
+#if defined(HAVE_RECVMMSG)
+DatagramTime DatagramSocket::parseControl(const msghdr& header, DatagramTime fallback, unsigned& drops)
+{
+    DatagramTime result = fallback;
+    unsigned newDrops = 0;
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&header); cm; cm = CMSG_NXTHDR(const_cast<msghdr*>(&header), cm))
+    {
+        if (cm->cmsg_level != SOL_SOCKET)
+            continue;
+
+        if (cm->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            timespec ts;
+            memcpy(&ts, CMSG_DATA(cm), sizeof ts);
+            result = DatagramTime(std::chrono::duration_cast<DatagramTime::duration>(
+                                      std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)));
+        }
+#if defined(SO_RXQ_OVFL)
+        else
+        if (cm->cmsg_type == SO_RXQ_OVFL)
+        {
+            // Kernel reports total number of drops on socket; wraps at 2^32
+            uint32_t total;
+            memcpy(&total, CMSG_DATA(cm), sizeof total);
+            newDrops += total - mKernelDrops;
+            mKernelDrops = total;
+        }
+#endif
+    }
+    if (newDrops)
+    {
+        drops += newDrops;
+        mLocalDrops += newDrops;
+    }
+    return result;
+}
+#endif
+
 void DatagramSocket::internalClose()
 {
     if (mHandle != INVALID_SOCKET)
@@ -146,6 +260,307 @@ SOCKET DatagramSocket::socket() const
     return mHandle;
 }
 
+void DatagramSocket::willSendTo(const InternetAddress& /*dest*/)
+{}
+
+bool DatagramSocket::enableTimestamps()
+{
+#if defined(SO_TIMESTAMPNS)
+    int on = 1;
+    return mHandle != INVALID_SOCKET && ::setsockopt(mHandle, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof on) == 0;
+#else
+    return false;
+#endif
+}
+
+bool DatagramSocket::enableDropCounter()
+{
+#if defined(SO_RXQ_OVFL)
+    int on = 1;
+    return mHandle != INVALID_SOCKET && ::setsockopt(mHandle, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof on) == 0;
+#else
+    return false;
+#endif
+}
+
+bool DatagramSocket::setBufferSizes(unsigned recvSize, unsigned sendSize)
+{
+    if (mHandle == INVALID_SOCKET)
+        return false;
+
+    bool result = true;
+    if (recvSize)
+    {
+        int value = static_cast<int>(recvSize);
+        if (::setsockopt(mHandle, SOL_SOCKET, SO_RCVBUF, (const char*)&value, sizeof value) != 0)
+            result = false;
+    }
+    if (sendSize)
+    {
+        int value = static_cast<int>(sendSize);
+        if (::setsockopt(mHandle, SOL_SOCKET, SO_SNDBUF, (const char*)&value, sizeof value) != 0)
+            result = false;
+    }
+    return result;
+}
+
+unsigned DatagramSocket::takeLocalDrops()
+{
+    return mLocalDrops.exchange(0);
+}
+
+DatagramBatch::DatagramBatch(unsigned capacity, unsigned packetSize)
+    :mCapacity(capacity), mPacketSize(packetSize)
+{
+    assert(capacity > 0 && packetSize > 0);
+    mBuffer.resize(size_t(capacity) * packetSize);
+    mSizes.resize(capacity);
+    mSources.resize(capacity);
+    mTimes.resize(capacity);
+#if defined(HAVE_RECVMMSG)
+    mHeaders.resize(capacity);
+    mVectors.resize(capacity);
+    mAddresses.resize(capacity);
+    mControl.resize(capacity * DATAGRAM_CONTROL_SIZE);
+#endif
+}
+
+DatagramBatch::~DatagramBatch()
+{}
+
+unsigned DatagramBatch::capacity() const
+{
+    return mCapacity;
+}
+
+unsigned DatagramBatch::count() const
+{
+    return mCount;
+}
+
+void DatagramBatch::clear()
+{
+    mCount = 0;
+}
+
+const uint8_t* DatagramBatch::dataAt(unsigned index) const
+{
+    assert(index < mCount);
+    return mBuffer.data() + size_t(index) * mPacketSize;
+}
+
+unsigned DatagramBatch::sizeAt(unsigned index) const
+{
+    assert(index < mCount);
+    return mSizes[index];
+}
+
+DatagramTime DatagramBatch::timeAt(unsigned index) const
+{
+    return mTimes[index];
+}
+
+unsigned DatagramBatch::drops() const
+{
+    return mDrops;
+}
+
+InternetAddress& DatagramBatch::sourceAt(unsigned index)
+{
+    assert(index < mCount);
+    return mSources[index];
+}
+
+// ----------------------- DatagramSendQueue -----------------------
+static thread_local DatagramSendQueue* ActiveSendQueue = nullptr;
+
+#if defined(HAVE_SENDMMSG)
+// Cleared on first GSO rejection (old kernel or NIC/driver without UDP segmentation support)
+static std::atomic_bool UdpGsoAvailable(true);
+
+static bool isGsoUnsupported(int error)
+{
+    return error == EINVAL || error == EIO || error == EOPNOTSUPP;
+}
+#endif
+
+DatagramSendQueue::DatagramSendQueue(unsigned capacity)
+    :mCapacity(capacity)
+{
+    assert(capacity > 0);
+    mBuffer.resize(size_t(capacity) * MAX_VALID_UDPPACKET_SIZE);
+    mItems.resize(capacity);
+#if defined(HAVE_SENDMMSG)
+    mHeaders.resize(capacity);
+    mVectors.resize(capacity);
+    mControl.resize(capacity);
+    for (auto& c: mControl)
+        c.resize(CMSG_SPACE(sizeof(uint16_t)));
+#endif
+}
+
+DatagramSendQueue::~DatagramSendQueue()
+{
+    flush();
+}
+
+uint8_t* DatagramSendQueue::bufferAt(unsigned index)
+{
+    return mBuffer.data() + size_t(index) * MAX_VALID_UDPPACKET_SIZE;
+}
+
+uint8_t* DatagramSendQueue::prepare()
+{
+    if (mCount == mCapacity)
+        flush();
+    return bufferAt(mCount);
+}
+
+void DatagramSendQueue::commit(const PDatagramSocket& socket, const InternetAddress& dest, unsigned size)
+{
+    assert(mCount < mCapacity && size <= MAX_VALID_UDPPACKET_SIZE);
+    socket->willSendTo(dest);
+
+    Item& item = mItems[mCount++];
+    item.mSocket = socket;
+    item.mDestination = dest;
+    item.mSize = size;
+}
+
+unsigned DatagramSendQueue::count() const
+{
+    return mCount;
+}
+
+void DatagramSendQueue::flush()
+{
+    unsigned index = 0;
+    while (index < mCount)
+    {
+#if defined(HAVE_SENDMMSG)
+        // Find run of datagrams going through the same socket handle
+        SOCKET handle = mItems[index].mSocket->socket();
+        unsigned end = index + 1;
+        while (end < mCount && mItems[end].mSocket->socket() == handle)
+            end++;
+
+        if (handle != INVALID_SOCKET)
+            sendRun(handle, index, end);
+        index = end;
+#else
+        Item& item = mItems[index];
+        item.mSocket->sendDatagram(item.mDestination, bufferAt(index), item.mSize);
+        index++;
+#endif
+    }
+
+    // Release socket references
+    for (unsigned i=0; i<mCount; i++)
+        mItems[i].mSocket.reset();
+    mCount = 0;
+}
+
+#if defined(HAVE_SENDMMSG)
+void DatagramSendQueue::sendRun(SOCKET handle, unsigned begin, unsigned end)
+{
+    // Build messages. Each message is either single datagram or GSO train of equal sized datagrams to one destination;
+    // GSO allows the last segment to be shorter.
+    bool useGso = UdpGsoAvailable;
+    unsigned messages = 0;
+    unsigned index = begin;
+    while (index < end)
+    {
+        unsigned segments = 1;
+        if (useGso)
+        {
+            const Item& first = mItems[index];
+            while (index + segments < end && segments < UDP_MAX_SEGMENTS &&
+                   (segments + 1) * first.mSize <= UDP_MAX_GSO_BYTES &&
+                   mItems[index + segments].mDestination == first.mDestination &&
+                   mItems[index + segments].mSize <= first.mSize &&
+                   mItems[index + segments - 1].mSize == first.mSize)
+                segments++;
+        }
+
+        msghdr& h = mHeaders[messages].msg_hdr;
+        memset(&h, 0, sizeof h);
+        h.msg_name = mItems[index].mDestination.genericsockaddr();
+        h.msg_namelen = mItems[index].mDestination.sockaddrLen();
+
+        // iovec entries of this message start at the same position as its items
+        for (unsigned i=0; i<segments; i++)
+        {
+            mVectors[index - begin + i].iov_base = bufferAt(index + i);
+            mVectors[index - begin + i].iov_len = mItems[index + i].mSize;
+        }
+        h.msg_iov = &mVectors[index - begin];
+        h.msg_iovlen = segments;
+
+        if (segments > 1)
+        {
+            std::vector<char>& control = mControl[messages];
+            memset(control.data(), 0, control.size());
+            h.msg_control = control.data();
+            h.msg_controllen = control.size();
+            cmsghdr* cm = CMSG_FIRSTHDR(&h);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segmentSize = static_cast<uint16_t>(mItems[index].mSize);
+            memcpy(CMSG_DATA(cm), &segmentSize, sizeof segmentSize);
+        }
+        mHeaders[messages].msg_len = 0;
+
+        messages++;
+        index += segments;
+    }
+
+    unsigned sent = 0;
+    while (sent < messages)
+    {
+        int rescode = ::sendmmsg(handle, mHeaders.data() + sent, messages - sent, MSG_DONTWAIT);
+        if (rescode > 0)
+        {
+            sent += rescode;
+            continue;
+        }
+
+        // Message at index 'sent' failed. If it is GSO train - send its datagrams one by one.
+        // GSO is switched off only when kernel / driver rejects it; transient errors (EAGAIN, ENOBUFS) are not about GSO.
+        int error = errno;
+        msghdr& failed = mHeaders[sent].msg_hdr;
+        if (failed.msg_iovlen > 1)
+        {
+            if (isGsoUnsupported(error) && UdpGsoAvailable.exchange(false))
+                ICELogInfo(<< "UDP GSO is not available (error " << error << "), switching to plain sendmmsg()");
+
+            for (size_t i=0; i<failed.msg_iovlen; i++)
+                ::sendto(handle, failed.msg_iov[i].iov_base, failed.msg_iov[i].iov_len, MSG_DONTWAIT,
+                         (const sockaddr*)failed.msg_name, failed.msg_namelen);
+        }
+        // Datagram is dropped otherwise - the same as failed sendto() in DatagramSocket::sendDatagram()
+        sent++;
+    }
+}
+#endif
+
+DatagramSendQueue* DatagramSendQueue::active()
+{
+    return ActiveSendQueue;
+}
+
+DatagramSendQueue::Scope::Scope(DatagramSendQueue& queue)
+    :mQueue(queue), mPrevious(ActiveSendQueue)
+{
+    ActiveSendQueue = &mQueue;
+}
+
+DatagramSendQueue::Scope::~Scope()
+{
+    mQueue.flush();
+    ActiveSendQueue = mPrevious;
+}
+
 DatagramAgreggator::DatagramAgreggator()
 {
     FD_ZERO(&mReadSet);
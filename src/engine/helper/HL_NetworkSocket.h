@@ -6,10 +6,22 @@
 #ifndef __NETWORK_SOCKET_H
 #define __NETWORK_SOCKET_H
 
+#include "../engine_config.h"
 #include "HL_InternetAddress.h"
 #include <vector>
 #include <memory>
 #include <chrono>
+#include <cstdint>
+#include <atomic>
+
+#if defined(TARGET_LINUX) || defined(TARGET_ANDROID)
+# include <sys/socket.h>
+# include <time.h>
+# define HAVE_RECVMMSG
+# define HAVE_SENDMMSG
+// Ancillary data space per received datagram: SCM_TIMESTAMPNS + SO_RXQ_OVFL
+# define DATAGRAM_CONTROL_SIZE (CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(uint32_t)))
+#endif
 
 class NetworkSocket
 {
@@ -18,6 +30,50 @@ public:
 
 };
 
+// Receive time of datagram. Wall clock - the same clock as kernel SO_TIMESTAMPNS and jrtplib's RTPTime use.
+typedef std::chrono::system_clock::time_point DatagramTime;
+
+// Set of preallocated buffers to receive a burst of datagrams by single call.
+// Buffers are reused between calls; nothing is allocated on receive.
+class DatagramBatch
+{
+    friend class DatagramSocket;
+public:
+    DatagramBatch(unsigned capacity = MAX_RECV_BATCH, unsigned packetSize = MAX_VALID_UDPPACKET_SIZE);
+    ~DatagramBatch();
+
+    unsigned          capacity() const;
+    unsigned          count() const;
+    void              clear();
+
+    const uint8_t*    dataAt(unsigned index) const;
+    unsigned          sizeAt(unsigned index) const;
+    InternetAddress&  sourceAt(unsigned index);
+
+    // Kernel receive timestamp if socket has SO_TIMESTAMPNS enabled, time of recv call otherwise
+    DatagramTime      timeAt(unsigned index) const;
+
+    // Number of datagrams kernel dropped on the socket (receive queue overflow) since previous read.
+    // Known only when SO_RXQ_OVFL is enabled for socket.
+    unsigned          drops() const;
+
+protected:
+    unsigned mCapacity;
+    unsigned mPacketSize;
+    unsigned mCount = 0;
+    unsigned mDrops = 0;
+    std::vector<uint8_t> mBuffer;           // mCapacity * mPacketSize bytes
+    std::vector<unsigned> mSizes;
+    std::vector<InternetAddress> mSources;
+    std::vector<DatagramTime> mTimes;
+#if defined(HAVE_RECVMMSG)
+    std::vector<mmsghdr> mHeaders;
+    std::vector<iovec> mVectors;
+    std::vector<sockaddr_storage> mAddresses;
+    std::vector<char> mControl;             // Ancillary data (timestamp and drop counter) per datagram
+#endif
+};
+
 class DatagramSocket
 {
     friend class SocketHeap;
@@ -30,22 +86,109 @@ public:
 
     virtual void      sendDatagram(InternetAddress& dest, const void* packetData, unsigned packetSize);
     virtual unsigned  recvDatagram(InternetAddress& src, void* packetBuffer, unsigned packetCapacity);
+
+    // Reads up to batch.capacity() pending datagrams without blocking. Returns number of datagrams read.
+    // Datagrams bigger than batch packet size are dropped.
+    virtual unsigned  recvDatagrams(DatagramBatch& batch);
     virtual void      closeSocket();
     virtual bool      isValid() const;
     virtual int       family() const;
     virtual bool      setBlocking(bool blocking);
     virtual SOCKET    socket() const;
 
+    // Asks kernel to stamp incoming datagrams (SO_TIMESTAMPNS); returns false if it is not supported
+    virtual bool      enableTimestamps();
+
+    // Asks kernel to report receive queue overflows (SO_RXQ_OVFL); returns false if it is not supported
+    virtual bool      enableDropCounter();
+
+    // Sets SO_RCVBUF / SO_SNDBUF; zero leaves system default. Returns false if kernel refused any of them.
+    virtual bool      setBufferSizes(unsigned recvSize, unsigned sendSize);
+
+    // Returns datagrams dropped by kernel before they were read and resets the counter.
+    // Owner of socket (media stream) calls it to attribute drops to its statistics.
+    virtual unsigned  takeLocalDrops();
+
+    // Called by send paths that write to socket() directly (DatagramSendQueue) instead of sendDatagram()
+    virtual void      willSendTo(const InternetAddress& dest);
+
     virtual void open(int family);
 
 protected:
     int mFamily;
     SOCKET mHandle;
     int mLocalPort;
+#if defined(HAVE_RECVMMSG)
+    // Extracts kernel timestamp ('fallback' if absent) from ancillary data of received datagram
+    // and adds new kernel drops reported there to 'drops' and to the socket counter
+    DatagramTime parseControl(const msghdr& header, DatagramTime fallback, unsigned& drops);
+#endif
+
+    unsigned mShard = 0;    // Index of SocketHeap shard serving this socket
+    uint32_t mKernelDrops = 0;                  // Last SO_RXQ_OVFL value seen by reader thread
+    std::atomic<unsigned> mLocalDrops = 0;      // Drops not taken by owner yet
     void internalClose();
 };
 typedef std::shared_ptr<DatagramSocket> PDatagramSocket;
 
+// Collects outgoing datagrams produced during single media tick and sends them together.
+// Datagrams for the same socket go out with one sendmmsg() call; consecutive equal sized
+// datagrams to the same destination are merged into single UDP_SEGMENT (GSO) message when kernel supports it.
+// Queue is activated per thread with Scope; senders check active() and fall back to direct send without it.
+class DatagramSendQueue
+{
+public:
+    DatagramSendQueue(unsigned capacity = MAX_SEND_BATCH);
+    ~DatagramSendQueue();
+
+    // Returns buffer (MAX_VALID_UDPPACKET_SIZE bytes) for the next datagram. Queue is flushed if it is full.
+    uint8_t*  prepare();
+
+    // Queues datagram written to buffer returned by last prepare()
+    void      commit(const PDatagramSocket& socket, const InternetAddress& dest, unsigned size);
+
+    // Sends all queued datagrams
+    void      flush();
+
+    unsigned  count() const;
+
+    // Returns queue activated for calling thread or nullptr
+    static DatagramSendQueue* active();
+
+    // Activates queue for calling thread; flushes it on destruction
+    class Scope
+    {
+    public:
+        Scope(DatagramSendQueue& queue);
+        ~Scope();
+    protected:
+        DatagramSendQueue& mQueue;
+        DatagramSendQueue* mPrevious;
+    };
+
+protected:
+    struct Item
+    {
+        PDatagramSocket mSocket;
+        InternetAddress mDestination;
+        unsigned        mSize = 0;
+    };
+
+    unsigned mCapacity;
+    unsigned mCount = 0;
+    std::vector<uint8_t> mBuffer;           // mCapacity * MAX_VALID_UDPPACKET_SIZE bytes
+    std::vector<Item> mItems;
+#if defined(HAVE_SENDMMSG)
+    std::vector<mmsghdr> mHeaders;
+    std::vector<iovec> mVectors;
+    std::vector<std::vector<char>> mControl;
+
+    void sendRun(SOCKET handle, unsigned begin, unsigned end);
+#endif
+
+    uint8_t* bufferAt(unsigned index);
+};
+
 class DatagramAgreggator
 {
 public:
@@ -0,0 +1,295 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "HL_PortAllocator.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+float PortAllocator::Usage::occupancy() const
+{
+    if (!mTotal)
+        return 0.0f;
+    return float(mUsed + mQuarantined) * 100.0f / mTotal;
+}
+
+PortAllocator::PortAllocator(std::chrono::seconds quarantineTime)
+    :mQuarantineTime(quarantineTime)
+{
+}
+
+void PortAllocator::setRange(unsigned short start, unsigned short finish)
+{
+    // Pairs start at even port and must fit into range completely
+    mStart = (start + 1) & ~1;
+    unsigned count = finish > mStart ? (finish - mStart + 1) / 2 : 0;
+
+    mPairs.assign(count, Pair());
+    mFree = List();
+    mQuarantine = List();
+    mHalf = List();
+    mUsed = 0;
+
+    // Offer pairs in random order like the old rand() based allocation did
+    std::vector<int> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::minstd_rand(std::random_device()()));
+    for (int index: order)
+        pushBack(mFree, index);
+}
+
+int PortAllocator::indexOf(unsigned short port) const
+{
+    if (port < mStart)
+        return -1;
+    int index = (port - mStart) / 2;
+    return index < (int)mPairs.size() ? index : -1;
+}
+
+void PortAllocator::pushBack(List& l, int index)
+{
+    Pair& p = mPairs[index];
+    p.mPrev = l.mTail;
+    p.mNext = -1;
+    if (l.mTail != -1)
+        mPairs[l.mTail].mNext = index;
+    else
+        l.mHead = index;
+    l.mTail = index;
+    l.mCount++;
+}
+
+void PortAllocator::unlink(List& l, int index)
+{
+    Pair& p = mPairs[index];
+    if (p.mPrev != -1)
+        mPairs[p.mPrev].mNext = p.mNext;
+    else
+        l.mHead = p.mNext;
+    if (p.mNext != -1)
+        mPairs[p.mNext].mPrev = p.mPrev;
+    else
+        l.mTail = p.mPrev;
+    p.mPrev = p.mNext = -1;
+    l.mCount--;
+}
+
+void PortAllocator::expireQuarantine()
+{
+    // Quarantine list is ordered by expiration time - check its head only
+    auto now = std::chrono::steady_clock::now();
+    while (mQuarantine.mHead != -1 && mPairs[mQuarantine.mHead].mQuarantineEnd <= now)
+    {
+        int index = mQuarantine.mHead;
+        unlink(mQuarantine, index);
+        mPairs[index].mState = State::Free;
+        pushBack(mFree, index);
+    }
+}
+
+unsigned short PortAllocator::allocPair()
+{
+    expireQuarantine();
+    if (mFree.mHead == -1)
+        return 0;
+
+    int index = mFree.mHead;
+    unlink(mFree, index);
+    mPairs[index].mState = State::Used;
+    mPairs[index].mRefs = 0;
+    mUsed++;
+    return static_cast<unsigned short>(mStart + index * 2);
+}
+
+unsigned short PortAllocator::allocPort()
+{
+    expireQuarantine();
+
+    // Finish split pairs first - free pairs are kept for RTP/RTCP pairs
+    if (mHalf.mHead != -1)
+    {
+        int index = mHalf.mHead;
+        Pair& p = mPairs[index];
+        int bit = (p.mTaken | p.mBusy) & 1 ? 1 : 0;
+        p.mTaken |= 1 << bit;
+        p.mPortRefs[bit] = 0;
+        settleSplit(index);
+        return static_cast<unsigned short>(mStart + index * 2 + bit);
+    }
+
+    if (mFree.mHead == -1)
+        return 0;
+
+    int index = mFree.mHead;
+    unlink(mFree, index);
+    Pair& p = mPairs[index];
+    p.mState = State::Used;
+    p.mRefs = 0;
+    p.mSplit = true;
+    p.mTaken = 1;
+    p.mBusy = 0;
+    p.mPortRefs[0] = p.mPortRefs[1] = 0;
+    mUsed++;
+    settleSplit(index);
+    return static_cast<unsigned short>(mStart + index * 2);
+}
+
+void PortAllocator::settleSplit(int index)
+{
+    Pair& p = mPairs[index];
+    if (p.mInHalfList)
+    {
+        unlink(mHalf, index);
+        p.mInHalfList = false;
+    }
+
+    if (!p.mTaken)
+    {
+        // Both ports are released - pair is whole again
+        p.mSplit = false;
+        p.mRefs = 0;
+        mUsed--;
+        if (p.mBusy)
+        {
+            p.mBusy = 0;
+            p.mState = State::Quarantined;
+            p.mQuarantineEnd = std::chrono::steady_clock::now() + mQuarantineTime;
+            pushBack(mQuarantine, index);
+        }
+        else
+        {
+            p.mState = State::Free;
+            pushBack(mFree, index);
+        }
+        return;
+    }
+
+    if ((p.mTaken | p.mBusy) != 3)
+    {
+        pushBack(mHalf, index);
+        p.mInHalfList = true;
+    }
+}
+
+bool PortAllocator::reserve(unsigned short port)
+{
+    int index = indexOf(port);
+    if (index < 0)
+        return false;
+
+    Pair& p = mPairs[index];
+    switch (p.mState)
+    {
+    case State::Free:
+        unlink(mFree, index);
+        mUsed++;
+        break;
+
+    case State::Quarantined:
+        // Somebody managed to bind it - so it is not busy anymore
+        unlink(mQuarantine, index);
+        mUsed++;
+        break;
+
+    case State::Used:
+        if (p.mSplit)
+        {
+            int bit = (port - mStart) & 1;
+            p.mPortRefs[bit]++;
+            if (!(p.mTaken & (1 << bit)))
+            {
+                p.mTaken |= 1 << bit;
+                p.mBusy &= ~(1 << bit);
+                settleSplit(index);
+            }
+            return true;
+        }
+        break;
+    }
+    p.mState = State::Used;
+    p.mRefs++;
+    return true;
+}
+
+void PortAllocator::release(unsigned short port)
+{
+    int index = indexOf(port);
+    if (index < 0)
+        return;
+
+    Pair& p = mPairs[index];
+    if (p.mState != State::Used)
+        return;
+
+    if (p.mSplit)
+    {
+        int bit = (port - mStart) & 1;
+        if (p.mPortRefs[bit] > 0)
+            p.mPortRefs[bit]--;
+        if (p.mPortRefs[bit] == 0 && (p.mTaken & (1 << bit)))
+        {
+            p.mTaken &= ~(1 << bit);
+            settleSplit(index);
+        }
+        return;
+    }
+
+    if (p.mRefs > 0)
+        p.mRefs--;
+    if (p.mRefs == 0)
+    {
+        // Released pairs go to the tail - recently closed ports are reused last
+        p.mState = State::Free;
+        pushBack(mFree, index);
+        mUsed--;
+    }
+}
+
+void PortAllocator::quarantine(unsigned short port)
+{
+    int index = indexOf(port);
+    if (index < 0)
+        return;
+
+    Pair& p = mPairs[index];
+    switch (p.mState)
+    {
+    case State::Free:
+        unlink(mFree, index);
+        break;
+
+    case State::Used:
+        if (p.mSplit)
+        {
+            // Other port of pair may be in use - block this one until the pair is released
+            int bit = (port - mStart) & 1;
+            p.mTaken &= ~(1 << bit);
+            p.mBusy |= 1 << bit;
+            p.mPortRefs[bit] = 0;
+            settleSplit(index);
+            return;
+        }
+        mUsed--;
+        break;
+
+    case State::Quarantined:
+        unlink(mQuarantine, index);
+        break;
+    }
+    p.mState = State::Quarantined;
+    p.mRefs = 0;
+    p.mQuarantineEnd = std::chrono::steady_clock::now() + mQuarantineTime;
+    pushBack(mQuarantine, index);
+}
+
+PortAllocator::Usage PortAllocator::usage() const
+{
+    Usage result;
+    result.mTotal = static_cast<unsigned>(mPairs.size());
+    result.mUsed = mUsed;
+    result.mQuarantined = mQuarantine.mCount;
+    result.mHalfUsed = mHalf.mCount;
+    return result;
+}
@@ -0,0 +1,105 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __HL_PORT_ALLOCATOR_H
+#define __HL_PORT_ALLOCATOR_H
+
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+
+// Tracks RTP/RTCP port pairs (even port + next odd port) inside configured range.
+// Free pairs are kept in intrusive list, so allocation, release and reservation are O(1)
+// regardless of range occupancy. Pairs that failed to bind (taken by other processes) are put
+// into quarantine and return to free list after cooldown.
+// Single sockets (rtcp-mux) take ports one by one: pair is split and its second port is offered to the next
+// allocPort() call, so they do not halve capacity of the range.
+// Class is not thread safe - owner has to serialize calls.
+class PortAllocator
+{
+public:
+    struct Usage
+    {
+        unsigned mTotal = 0;            // Number of pairs in range
+        unsigned mUsed = 0;             // Allocated or reserved pairs
+        unsigned mQuarantined = 0;      // Pairs found busy in other processes
+        unsigned mHalfUsed = 0;         // Split pairs with one port still free (included into mUsed)
+
+        // Used + quarantined pairs in percents
+        float occupancy() const;
+    };
+
+    PortAllocator(std::chrono::seconds quarantineTime = std::chrono::seconds(30));
+
+    // Resets allocator to range [start..finish]. All pairs become free.
+    void setRange(unsigned short start, unsigned short finish);
+
+    // Returns even port of free pair or 0 when no pair is available. Pair starts with zero references.
+    unsigned short allocPair();
+
+    // Returns single port or 0 when no port is available. Free port of split pair is preferred,
+    // otherwise free pair is split. Port starts with zero references.
+    unsigned short allocPort();
+
+    // Marks port's pair used (if it is free) and adds reference to it; port of split pair is referenced alone.
+    // Returns false if port is outside of range.
+    bool reserve(unsigned short port);
+
+    // Removes reference from port's pair (or port of split pair); pair becomes free when the last reference is gone
+    void release(unsigned short port);
+
+    // Moves port's pair to quarantine - it is not offered until cooldown expires.
+    // Port of split pair is blocked alone; pair goes to quarantine when its other port is released.
+    void quarantine(unsigned short port);
+
+    Usage usage() const;
+
+protected:
+    enum class State: uint8_t
+    {
+        Free,
+        Used,
+        Quarantined
+    };
+
+    struct Pair
+    {
+        int mPrev = -1, mNext = -1;     // Links inside free or quarantine list
+        State mState = State::Free;
+        uint16_t mRefs = 0;
+        std::chrono::steady_clock::time_point mQuarantineEnd;
+
+        // Split pair (allocPort()) - ports are referenced separately; bit 0 is even port, bit 1 is odd one
+        bool mSplit = false;
+        bool mInHalfList = false;
+        uint8_t mTaken = 0;             // Allocated ports
+        uint8_t mBusy = 0;              // Ports found busy in other processes
+        uint16_t mPortRefs[2] = {0, 0};
+    };
+
+    struct List
+    {
+        int mHead = -1, mTail = -1;
+        unsigned mCount = 0;
+    };
+
+    unsigned short mStart = 0;
+    std::chrono::seconds mQuarantineTime;
+    std::vector<Pair> mPairs;
+    List mFree, mQuarantine, mHalf;     // mHalf - split pairs with one free port
+    unsigned mUsed = 0;
+
+    int indexOf(unsigned short port) const;
+    void pushBack(List& l, int index);
+    void unlink(List& l, int index);
+
+    // Returns pairs with expired quarantine to free list
+    void expireQuarantine();
+
+    // Puts split pair into the list matching its ports - half list, free list or quarantine
+    void settleSplit(int index);
+};
+
+#endif
@@ -13,6 +13,7 @@
 #endif
 
 #include "HL_Rtp.h"
+#include "HL_RtpMemoryPool.h"
 #include "HL_Exception.h"
 #include "HL_Log.h"
 
@@ -91,6 +92,104 @@ bool RtpHelper::isRtp(const void* buffer, size_t length)
     return rtp;
 }
 
+bool RtpHelper::parseRtp(const void* buffer, size_t length, RtpPacketView& view)
+{
+    if (!isRtp(buffer, length))
+        return false;
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer);
+    const RtpHeader* h = reinterpret_cast<const RtpHeader*>(buffer);
+
+    size_t offset = 12 + h->cc * sizeof(uint32_t);
+    if (h->x)
+    {
+        if (offset + 4 > length)
+            return false;
+        offset += 4 + ((data[offset + 2] << 8) | data[offset + 3]) * sizeof(uint32_t);
+    }
+
+    size_t padding = 0;
+    if (h->p)
+    {
+        padding = data[length - 1];
+        if (!padding)
+            return false;
+    }
+
+    if (offset + padding > length)
+        return false;
+
+    view.mPayloadType = h->pt;
+    view.mMarker = h->m;
+    view.mSeqno = ntohs(h->seq);
+    view.mTimestamp = ntohl(h->ts);
+    view.mSsrc = ntohl(h->ssrc);
+    view.mPayload = data + offset;
+    view.mPayloadLength = length - offset - padding;
+    return true;
+}
+
+std::shared_ptr<jrtplib::RTPPacket> RtpHelper::makePacket(const RtpPacketView& view, uint32_t extendedSeqno, const jrtplib::RTPTime& receiveTime,
+                                                          jrtplib::RTPMemoryManager* mgr)
+{
+    auto packet = std::allocate_shared<jrtplib::RTPPacket>(RtpMemoryPool::Allocator<jrtplib::RTPPacket>(), view.mPayloadType, view.mPayload, view.mPayloadLength, view.mSeqno,
+                                                           view.mTimestamp, view.mSsrc, view.mMarker, 0, nullptr,
+                                                           false, 0, 0, nullptr, 0, mgr);
+    if (packet->GetCreationError() != 0)
+        return nullptr;
+
+    packet->SetExtendedSequenceNumber(extendedSeqno);
+    packet->SetReceiveTime(receiveTime);
+    return packet;
+}
+
+std::shared_ptr<jrtplib::RTPPacket> RtpHelper::adoptPacket(uint8_t* data, size_t length, uint32_t extendedSeqno, const jrtplib::RTPTime& receiveTime,
+                                                           jrtplib::RTPMemoryManager* mgr)
+{
+    // Parsed packet takes the buffer from raw one; otherwise raw packet frees it
+    jrtplib::RTPRawPacket raw(data, length, nullptr, receiveTime, true, mgr);
+    auto packet = std::allocate_shared<jrtplib::RTPPacket>(RtpMemoryPool::Allocator<jrtplib::RTPPacket>(), raw, mgr);
+    if (packet->GetCreationError() != 0)
+        return nullptr;
+
+    packet->SetExtendedSequenceNumber(extendedSeqno);
+    return packet;
+}
+
+uint32_t RtpSequenceExtender::extend(uint16_t seqno)
+{
+    if (!mHighest)
+    {
+        mHighest = seqno;
+        return seqno;
+    }
+
+    // Signed distance from highest seen - reordered packets get previous cycle when needed
+    uint32_t result = *mHighest + int16_t(seqno - uint16_t(*mHighest));
+    if (int32_t(result - *mHighest) > 0)
+        mHighest = result;
+    return result;
+}
+
+PacketKind RtpHelper::classify(const void* buffer, size_t length)
+{
+    if (!length)
+        return PacketKind::Unknown;
+
+    uint8_t b = *reinterpret_cast<const uint8_t*>(buffer);
+    if (b <= 3)
+        return PacketKind::Stun;
+    if (b >= 16 && b <= 19)
+        return PacketKind::Zrtp;
+    if (b >= 20 && b <= 63)
+        return PacketKind::Dtls;
+    if (b >= 64 && b <= 79)
+        return PacketKind::TurnChannel;
+    if (b >= 128 && b <= 191)
+        return PacketKind::RtpRtcp;
+    return PacketKind::Unknown;
+}
+
 bool RtpHelper::isRtpOrRtcp(const void* buffer, size_t length)
 {
     // A minimal RTCP packet (e.g. an empty receiver report) is 8 bytes
@@ -14,6 +14,7 @@
 #include <string>
 #include <memory>
 #include <chrono>
+#include <optional>
 
 // Class to carry rtp/rtcp socket pair
 template<class T>
@@ -32,9 +33,58 @@ struct RtpPair
     bool multiplexed() const { return mRtp == mRtcp; }
 };
 
+// Kind of packet arriving on media port; decided by its first byte as described in RFC 7983
+enum class PacketKind
+{
+    Stun,           // 0..3
+    Zrtp,           // 16..19
+    Dtls,           // 20..63
+    TurnChannel,    // 64..79
+    RtpRtcp,        // 128..191
+    Unknown
+};
+
+// Fields of RTP packet needed for media; payload points into parsed buffer
+struct RtpPacketView
+{
+    uint8_t         mPayloadType = 0;
+    bool            mMarker = false;
+    uint16_t        mSeqno = 0;
+    uint32_t        mTimestamp = 0;
+    uint32_t        mSsrc = 0;
+    const uint8_t*  mPayload = nullptr;
+    size_t          mPayloadLength = 0;     // Without padding
+};
+
+// Extends 16-bit sequence numbers of single RTP source to 32 bits (RFC 3550 cycle counting)
+class RtpSequenceExtender
+{
+public:
+    uint32_t extend(uint16_t seqno);
+
+protected:
+    std::optional<uint32_t> mHighest;
+};
+
 class RtpHelper
 {
 public:
+    // Parses RTP header without allocations. Returns false for malformed packet.
+    static bool     parseRtp(const void* buffer, size_t length, RtpPacketView& view);
+
+    // Makes jrtplib packet holding copy of the payload only (no CSRC / extension).
+    // Packet object comes from RtpMemoryPool; payload buffer - from 'mgr' (global heap if null).
+    static std::shared_ptr<jrtplib::RTPPacket> makePacket(const RtpPacketView& view, uint32_t extendedSeqno, const jrtplib::RTPTime& receiveTime,
+                                                          jrtplib::RTPMemoryManager* mgr = nullptr);
+
+    // Makes jrtplib packet owning complete RTP packet in 'data' - no copy is made. 'data' must be allocated from 'mgr';
+    // it is released by this call when packet cannot be parsed.
+    static std::shared_ptr<jrtplib::RTPPacket> adoptPacket(uint8_t* data, size_t length, uint32_t extendedSeqno, const jrtplib::RTPTime& receiveTime,
+                                                           jrtplib::RTPMemoryManager* mgr);
+
+    // Constant time demultiplexing of packets sharing the same socket
+    static PacketKind classify(const void* buffer, size_t length);
+
     static bool     isRtp(const void* buffer, size_t length);
     static int      findPtype(const void* buffer, size_t length);
     static int      findPacketNo(const void *buffer, size_t length);
@@ -0,0 +1,203 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "HL_RtpMemoryPool.h"
+
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+// Every block starts with header keeping its size class; payload stays max-aligned
+static constexpr size_t BlockHeaderSize = alignof(std::max_align_t) > sizeof(uint32_t) ? alignof(std::max_align_t) : sizeof(uint32_t);
+
+RtpMemoryPool& RtpMemoryPool::instance()
+{
+    // Never destroyed - packets may be released by static destructors of other objects
+    static RtpMemoryPool* pool = new RtpMemoryPool();
+    return *pool;
+}
+
+RtpMemoryPool::RtpMemoryPool()
+{}
+
+RtpMemoryPool::ThreadCache::~ThreadCache()
+{
+    RtpMemoryPool& pool = RtpMemoryPool::instance();
+    for (uint32_t c = 0; c < ClassCount; c++)
+        pool.give(*this, c, mCount[c]);
+}
+
+RtpMemoryPool::ThreadCache& RtpMemoryPool::threadCache()
+{
+    thread_local ThreadCache cache;
+    return cache;
+}
+
+size_t RtpMemoryPool::blockSize(size_t sizeClass)
+{
+    return MinBlockSize << sizeClass;
+}
+
+uint32_t RtpMemoryPool::findClass(size_t size)
+{
+    for (uint32_t c = 0; c < ClassCount; c++)
+        if (size + BlockHeaderSize <= blockSize(c))
+            return c;
+    return HeapClass;
+}
+
+void RtpMemoryPool::take(ThreadCache& cache, uint32_t sizeClass)
+{
+    Shared& shared = mShared[sizeClass];
+    std::unique_lock<std::mutex> l(shared.mGuard);
+    for (size_t i = 0; i < TransferBatch && shared.mHead; i++)
+    {
+        Block* b = shared.mHead;
+        shared.mHead = b->mNext;
+        b->mNext = cache.mHead[sizeClass];
+        cache.mHead[sizeClass] = b;
+        cache.mCount[sizeClass]++;
+    }
+}
+
+void RtpMemoryPool::give(ThreadCache& cache, uint32_t sizeClass, size_t count)
+{
+    if (!count)
+        return;
+
+    Shared& shared = mShared[sizeClass];
+    std::unique_lock<std::mutex> l(shared.mGuard);
+    for (size_t i = 0; i < count && cache.mHead[sizeClass]; i++)
+    {
+        Block* b = cache.mHead[sizeClass];
+        cache.mHead[sizeClass] = b->mNext;
+        cache.mCount[sizeClass]--;
+        b->mNext = shared.mHead;
+        shared.mHead = b;
+    }
+}
+
+void* RtpMemoryPool::allocate(size_t size)
+{
+    uint32_t sizeClass = findClass(size);
+    uint8_t* block = nullptr;
+
+    if (sizeClass == HeapClass)
+    {
+        block = static_cast<uint8_t*>(malloc(size + BlockHeaderSize));
+        if (!block)
+            throw std::bad_alloc();
+    }
+    else
+    {
+        ThreadCache& cache = threadCache();
+        Counters& counters = mCounters[sizeClass];
+
+        if (!cache.mHead[sizeClass])
+            take(cache, sizeClass);
+
+        if (cache.mHead[sizeClass])
+        {
+            Block* b = cache.mHead[sizeClass];
+            cache.mHead[sizeClass] = b->mNext;
+            cache.mCount[sizeClass]--;
+            block = reinterpret_cast<uint8_t*>(b);
+            counters.mHits.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            block = static_cast<uint8_t*>(malloc(blockSize(sizeClass)));
+            if (!block)
+                throw std::bad_alloc();
+        }
+
+        counters.mAllocations.fetch_add(1, std::memory_order_relaxed);
+        int64_t inUse = counters.mInUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        int64_t highWater = counters.mHighWater.load(std::memory_order_relaxed);
+        while (inUse > highWater && !counters.mHighWater.compare_exchange_weak(highWater, inUse, std::memory_order_relaxed))
+            ;
+    }
+
+    *reinterpret_cast<uint32_t*>(block) = sizeClass;
+    return block + BlockHeaderSize;
+}
+
+void RtpMemoryPool::release(void* buffer)
+{
+    if (!buffer)
+        return;
+
+    uint8_t* block = static_cast<uint8_t*>(buffer) - BlockHeaderSize;
+    uint32_t sizeClass = *reinterpret_cast<uint32_t*>(block);
+    if (sizeClass == HeapClass)
+    {
+        free(block);
+        return;
+    }
+
+    mCounters[sizeClass].mInUse.fetch_sub(1, std::memory_order_relaxed);
+
+    ThreadCache& cache = threadCache();
+    Block* b = reinterpret_cast<Block*>(block);
+    b->mNext = cache.mHead[sizeClass];
+    cache.mHead[sizeClass] = b;
+    if (++cache.mCount[sizeClass] > ThreadCacheLimit)
+        give(cache, sizeClass, TransferBatch);
+}
+
+void* RtpMemoryPool::AllocateBuffer(size_t numbytes, int /*memtype*/)
+{
+    return allocate(numbytes);
+}
+
+void RtpMemoryPool::FreeBuffer(void* buffer)
+{
+    release(buffer);
+}
+
+std::vector<RtpMemoryPool::ClassStatistics> RtpMemoryPool::statistics() const
+{
+    std::vector<ClassStatistics> result(ClassCount);
+    for (size_t c = 0; c < ClassCount; c++)
+    {
+        result[c].mBlockSize = blockSize(c);
+        result[c].mAllocations = mCounters[c].mAllocations.load(std::memory_order_relaxed);
+        result[c].mHits = mCounters[c].mHits.load(std::memory_order_relaxed);
+        result[c].mInUse = mCounters[c].mInUse.load(std::memory_order_relaxed);
+        result[c].mHighWater = mCounters[c].mHighWater.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+float RtpMemoryPool::hitRate() const
+{
+    uint64_t allocations = 0, hits = 0;
+    for (const auto& s: statistics())
+    {
+        allocations += s.mAllocations;
+        hits += s.mHits;
+    }
+    return allocations ? float(hits) / allocations : 0.0f;
+}
+
+size_t RtpMemoryPool::highWaterBytes() const
+{
+    size_t result = 0;
+    for (const auto& s: statistics())
+        result += s.mBlockSize * s.mHighWater;
+    return result;
+}
+
+std::string RtpMemoryPool::toString() const
+{
+    std::ostringstream oss;
+    oss << "RTP memory pool hit rate: " << hitRate();
+    for (const auto& s: statistics())
+    {
+        if (s.mAllocations)
+            oss << ", " << s.mBlockSize << "b: " << s.mAllocations << "/" << s.mHits << " in use " << s.mInUse << " max " << s.mHighWater;
+    }
+    return oss.str();
+}
@@ -0,0 +1,115 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __HL_RTP_MEMORY_POOL_H
+#define __HL_RTP_MEMORY_POOL_H
+
+#include "jrtplib/src/rtpmemorymanager.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Process-wide size-class pool for RTP packets and jrtplib objects.
+// Every thread keeps its own free lists, so allocation and release take no lock;
+// blocks move between thread caches and shared per-class lists in batches only.
+// Blocks may be released by another thread than allocated them (network -> playout).
+// Requests larger than biggest class go to global heap.
+class RtpMemoryPool: public jrtplib::RTPMemoryManager
+{
+public:
+    static RtpMemoryPool& instance();
+
+    void* allocate(size_t size);
+    void  release(void* buffer);
+
+    // jrtplib::RTPMemoryManager
+    void* AllocateBuffer(size_t numbytes, int memtype) override;
+    void  FreeBuffer(void* buffer) override;
+
+    struct ClassStatistics
+    {
+        size_t      mBlockSize = 0;
+        uint64_t    mAllocations = 0;   // All allocations of this class
+        uint64_t    mHits = 0;          // Allocations served by recycled block
+        int64_t     mInUse = 0;         // Blocks allocated now
+        int64_t     mHighWater = 0;     // Maximal mInUse
+    };
+    std::vector<ClassStatistics> statistics() const;
+
+    // Share of allocations served by recycled blocks, [0..1]
+    float hitRate() const;
+
+    // Sum of per-class high-water marks, bytes
+    size_t highWaterBytes() const;
+
+    std::string toString() const;
+
+    // STL allocator on top of the pool - for std::allocate_shared() and containers
+    template <typename T>
+    struct Allocator
+    {
+        typedef T value_type;
+
+        Allocator() = default;
+        template <typename U> Allocator(const Allocator<U>&) {}
+
+        T* allocate(size_t n)                   { return static_cast<T*>(RtpMemoryPool::instance().allocate(n * sizeof(T))); }
+        void deallocate(T* p, size_t)           { RtpMemoryPool::instance().release(p); }
+
+        template <typename U> bool operator == (const Allocator<U>&) const { return true; }
+        template <typename U> bool operator != (const Allocator<U>&) const { return false; }
+    };
+
+protected:
+    RtpMemoryPool();
+
+    static constexpr size_t ClassCount = 6;            // 64, 128, ... 2048 bytes
+    static constexpr size_t MinBlockSize = 64;
+    static constexpr size_t ThreadCacheLimit = 64;     // Blocks per class kept by thread
+    static constexpr size_t TransferBatch = 32;        // Blocks moved between thread and shared list at once
+    static constexpr uint32_t HeapClass = ClassCount;  // Marks block taken from global heap
+
+    struct Block
+    {
+        Block* mNext;
+    };
+
+    struct Shared
+    {
+        std::mutex  mGuard;
+        Block*      mHead = nullptr;
+    };
+
+    struct Counters
+    {
+        std::atomic<uint64_t>   mAllocations = 0,
+                                mHits = 0;
+        std::atomic<int64_t>    mInUse = 0,
+                                mHighWater = 0;
+    };
+
+    struct ThreadCache
+    {
+        Block*  mHead[ClassCount] = {nullptr};
+        size_t  mCount[ClassCount] = {0};
+        ~ThreadCache();
+    };
+
+    Shared   mShared[ClassCount];
+    Counters mCounters[ClassCount];
+
+    static ThreadCache& threadCache();
+    static size_t blockSize(size_t sizeClass);
+    static uint32_t findClass(size_t size);
+
+    void take(ThreadCache& cache, uint32_t sizeClass);
+    void give(ThreadCache& cache, uint32_t sizeClass, size_t count);
+};
+
+#endif
@@ -16,6 +16,7 @@
 #endif
 
 #include "HL_SocketHeap.h"
+#include "HL_DatagramMux.h"
 #include "HL_Log.h"
 #include "HL_Sync.h"
 #include "HL_Exception.h"
@@ -34,12 +35,21 @@ using namespace std::chrono_literals;
 SocketSink::~SocketSink()
 {}
 
+void SocketSink::onReceivedBatch(PDatagramSocket socket, DatagramBatch& batch)
+{
+    for (unsigned i=0; i<batch.count(); i++)
+        onReceivedData(socket, batch.sourceAt(i), batch.dataAt(i), batch.sizeAt(i), batch.timeAt(i));
+}
+
 // ----------------------------- SocketHeap -------------------------
 
 SocketHeap::SocketHeap(unsigned short start, unsigned short finish)
 {
     mStart =  start;
     mFinish = finish;
+    mPorts.setRange(start, finish);
+    mMux = std::make_unique<DatagramMux>();
+    setShardCount(1);
 }
 
 SocketHeap::~SocketHeap()
@@ -47,22 +57,115 @@ SocketHeap::~SocketHeap()
     stop();
 }
 
+void SocketHeap::setShardCount(unsigned count)
+{
+    if (!count)
+        count = 1;
+
+    for (auto& shard: mShards)
+    {
+        if (shard->mWorkerThread || !shard->mSocketMap.empty() || !shard->mAddVector.empty())
+        {
+            ICELogError(<< "Cannot change socket heap shard count while it is in use");
+            return;
+        }
+    }
+
+    mShards.clear();
+    for (unsigned i=0; i<count; i++)
+    {
+        auto shard = std::make_unique<Shard>();
+        shard->mIndex = i;
+#if defined(HAVE_EPOLL)
+        // Failure here is not fatal - the worker thread falls back to select()
+        shard->mEpoll.open();
+#endif
+        mShards.push_back(std::move(shard));
+    }
+}
+
+unsigned SocketHeap::shardCount() const
+{
+    return static_cast<unsigned>(mShards.size());
+}
+
+unsigned SocketHeap::shardFor(SocketSink* sink)
+{
+    Lock l(mGuard);
+    auto iter = mSinkShards.find(sink);
+    if (iter != mSinkShards.end())
+        return iter->second.mShard;
+
+    // Sink addresses are aligned heap pointers - hashing them leaves most shards idle, so balance by load
+    unsigned result = 0;
+    for (unsigned i=1; i<mShards.size(); i++)
+    {
+        if (mShards[i]->mSinks < mShards[result]->mSinks)
+            result = i;
+    }
+    return result;
+}
+
+SocketHeap::Shard& SocketHeap::shardAt(int index, SocketSink* sink)
+{
+    if (index < 0 || index >= (int)mShards.size())
+        index = shardFor(sink);
+    return *mShards[index];
+}
+
+void SocketHeap::setIoUring(bool enabled)
+{
+    mUseIoUring = enabled;
+}
+
+unsigned SocketHeap::ioUringShards() const
+{
+    unsigned result = 0;
+#if defined(HAVE_IO_URING)
+    for (auto& shard: mShards)
+        if (shard->mRing.isOpened())
+            result++;
+#endif
+    return result;
+}
+
 void SocketHeap::start()
 {
-    if (!mWorkerThread)
-        mWorkerThread = std::make_shared<std::thread>(&SocketHeap::thread, this);
+    for (auto& shard: mShards)
+    {
+#if defined(HAVE_IO_URING)
+        // Failure here is not fatal - kernel may be too old or io_uring disabled by policy
+        if (mUseIoUring && !shard->mWorkerThread && !shard->mRing.isOpened() && shard->mRing.open())
+        {
+            ICELogInfo(<< "Socket heap shard " << shard->mIndex << " uses io_uring");
+
+            // Sockets created before start() are armed by reactor thread as well
+            Lock l(shard->mGuard);
+            processDeleted(*shard);
+            Lock dl(shard->mDeleteGuard);
+            for (auto& item: shard->mSocketMap)
+                shard->mArmVector.push_back(item.second.mSocket);
+        }
+#endif
+        if (!shard->mWorkerThread)
+            shard->mWorkerThread = std::make_shared<std::thread>(&SocketHeap::thread, this, std::ref(*shard));
+    }
 }
 
 void SocketHeap::stop()
 {
-    if (mWorkerThread)
+    mShutdown = true;
+    for (auto& shard: mShards)
     {
-        mShutdown = true;
-        if (mWorkerThread->joinable())
-            mWorkerThread->join();
+        if (shard->mWorkerThread)
+        {
+            if (shard->mWorkerThread->joinable())
+                shard->mWorkerThread->join();
 
-        mWorkerThread.reset();
+            shard->mWorkerThread.reset();
+        }
     }
+    mShutdown = false;
 }
 
 void SocketHeap::setRange(unsigned short start, unsigned short finish)
@@ -72,6 +175,7 @@ void SocketHeap::setRange(unsigned short start, unsigned short finish)
     Lock l(mGuard);
     mStart = start;
     mFinish = finish;
+    mPorts.setRange(start, finish);
 }
 
 void SocketHeap::range(unsigned short &start, unsigned short &finish)
@@ -82,48 +186,153 @@ void SocketHeap::range(unsigned short &start, unsigned short &finish)
     finish = mFinish;
 }
 
-RtpPair<PDatagramSocket> SocketHeap::allocSocketPair(int family, SocketSink *sink, Multiplex m)
+PortAllocator::Usage SocketHeap::portUsage()
+{
+    Lock l(mGuard);
+    return mPorts.usage();
+}
+
+void SocketHeap::setBufferSizes(unsigned recvSize, unsigned sendSize)
+{
+    Lock l(mGuard);
+    mRecvBufferSize = recvSize;
+    mSendBufferSize = sendSize;
+}
+
+void SocketHeap::bufferSizes(unsigned& recvSize, unsigned& sendSize)
+{
+    Lock l(mGuard);
+    recvSize = mRecvBufferSize;
+    sendSize = mSendBufferSize;
+}
+
+uint64_t SocketHeap::localDrops() const
+{
+    return mLocalDrops;
+}
+
+void SocketHeap::setMultiplexPort(unsigned short port, unsigned carriers)
+{
+    std::vector<PDatagramSocket> previous;
+    {
+        Lock ml(mMuxGuard);
+        Lock l(mGuard);
+        mMuxPort = port;
+        mMuxCarriers = carriers ? carriers : 1;
+        previous = mMux->clear();
+    }
+
+    for (auto& carrier: previous)
+        freeSocket(carrier);
+}
+
+unsigned short SocketHeap::multiplexPort()
+{
+    Lock l(mGuard);
+    return mMuxPort;
+}
+
+DatagramMux& SocketHeap::mux()
+{
+    return *mMux;
+}
+
+PDatagramSocket SocketHeap::createVirtualSocket(int family, SocketSink* sink)
+{
+    // Sockets are created without heap lock - shard reactors take it from under their own locks
+    Lock ml(mMuxGuard);
+    unsigned short port;
+    unsigned carriers;
+    {
+        Lock l(mGuard);
+        port = mMuxPort;
+        carriers = mMuxCarriers;
+    }
+
+    if (!mMux->hasCarrier(family))
+    {
+        // Kernel chooses carrier by address hash, so RTP / RTCP / STUN of one session may come on different carriers.
+        // All carriers are put into shard of the mux - session callbacks never run concurrently.
+        for (unsigned i=0; i<carriers; i++)
+            mMux->addCarrier(createSocket(family, mMux.get(), port, shardAt(-1, mMux.get()), carriers > 1));
+
+        ICELogInfo(<< "Single port media mode on port " << port << " with " << carriers << " "
+                   << (family == AF_INET ? "AF_INET" : "AF_INET6") << " socket(s) in shard " << shardFor(mMux.get()));
+    }
+
+    PDatagramSocket result = mMux->createSocket(family, sink);
+    if (!result)
+        throw Exception(ERR_NET_FAILED);
+    return result;
+}
+
+RtpPair<PDatagramSocket> SocketHeap::allocSocketPair(int family, SocketSink *sink, Multiplex m, int shard)
 {
+    if (multiplexPort())
+    {
+        // RTCP is always multiplexed with RTP in single port mode
+        PDatagramSocket result = createVirtualSocket(family, sink);
+        return RtpPair<PDatagramSocket>(result, result);
+    }
+
+    // Pin both sockets to one shard
+    Shard& target = shardAt(shard, sink);
+
     PDatagramSocket rtp, rtcp;
-    for (int attempt=0; (!rtp || !rtcp) && attempt < (mFinish - mStart)/2; attempt++)
+    for (;;)
     {
-        // Allocate RTP
+        unsigned short port;
+        {
+            Lock l(mGuard);
+            port = mPorts.allocPair();
+        }
+        if (!port)
+        {
+            auto usage = portUsage();
+            ICELogError(<< "No free port pair, " << usage.mUsed << " used and " << usage.mQuarantined
+                        << " quarantined of " << usage.mTotal);
+            throw Exception(ERR_NET_FAILED);
+        }
+
         try
         {
-            rtp = allocSocket(family, sink);
+            rtp = createSocket(family, sink, port, target);
             if (m == DoMultiplexing)
                 rtcp = rtp;
             else
-                rtcp = allocSocket(family, sink, rtp->localport() + 1);
+                rtcp = createSocket(family, sink, port + 1, target);
+            break;
         }
-        catch(...)
+        catch(const Exception& e)
         {
             // Release a partially allocated pair before retrying - otherwise
             // the RTP socket from this attempt leaks into the socket map.
+            bool created = (bool)rtp;
             if (rtp)
             {
                 freeSocket(rtp);
                 rtp.reset();
             }
-            if (rtcp)
+
+            Lock l(mGuard);
+            if (e.subcode() == WSAEADDRINUSE)
             {
-                freeSocket(rtcp);
-                rtcp.reset();
+                // Pair is busy in other process - try next one
+                mPorts.quarantine(port);
+                continue;
             }
+
+            // Pair without sockets has no reference to drop later
+            if (!created)
+                mPorts.release(port);
+            throw;
         }
     }
 
-    if (!rtp || !rtcp)
-    {
-        if (rtp)
-            freeSocket(rtp);
-        if (rtcp)
-            freeSocket(rtcp);
-        throw Exception(ERR_NET_FAILED);
-    }
     ICELogInfo(<< "Allocated socket pair " << (family == AF_INET ? "AF_INET" : "AF_INET6") << " "
                << rtp->socket() << ":" << rtcp->socket()
-               << " at ports " << rtp->localport() << ":"<< rtcp->localport());
+               << " at ports " << rtp->localport() << ":"<< rtcp->localport()
+               << " in shard " << target.mIndex);
 
     return RtpPair<PDatagramSocket>(rtp, rtcp);
 }
@@ -134,9 +343,48 @@ void SocketHeap::freeSocketPair(const RtpPair<PDatagramSocket> &p)
     freeSocket(p.mRtcp);
 }
 
-PDatagramSocket SocketHeap::allocSocket(int family, SocketSink* sink, int port)
+PDatagramSocket SocketHeap::allocSocket(int family, SocketSink* sink, int port, int shardIndex)
+{
+    if (multiplexPort())
+        return createVirtualSocket(family, sink);
+
+    Shard& shard = shardAt(shardIndex, sink);
+
+    // A fixed port cannot be retried - it is owned by caller or by another process
+    if (port)
+        return createSocket(family, sink, port, shard);
+
+    for (;;)
+    {
+        // Single socket takes single port - odd ports are not wasted on rtcp-mux streams
+        unsigned short testport;
+        {
+            Lock l(mGuard);
+            testport = mPorts.allocPort();
+        }
+        if (!testport)
+            throw Exception(ERR_NET_FAILED);
+
+        try
+        {
+            return createSocket(family, sink, testport, shard);
+        }
+        catch(const Exception& e)
+        {
+            Lock l(mGuard);
+            if (e.subcode() == WSAEADDRINUSE)
+            {
+                mPorts.quarantine(testport);
+                continue;
+            }
+            mPorts.release(testport);
+            throw;
+        }
+    }
+}
+
+PDatagramSocket SocketHeap::createSocket(int family, SocketSink* sink, unsigned short port, Shard& shard, bool reusePort)
 {
-    Lock l(mGuard);
     SOCKET sock = ::socket(family, SOCK_DGRAM, IPPROTO_UDP);
     if (sock == INVALID_SOCKET)
     {
@@ -147,58 +395,104 @@ PDatagramSocket SocketHeap::allocSocket(int family, SocketSink* sink, int port)
         return result;
     }
 
-    // Obtain port number
-    sockaddr_in addr;
-    sockaddr_in6 addr6;
     int result = 0;
-    int testport;
-    // A fixed port cannot be retried (it would loop forever if the port is
-    // owned by another process); random ports get a bounded number of attempts.
-    int attemptsLeft = port ? 1 : 100;
-    do
+#if defined(SO_REUSEPORT)
+    if (reusePort)
     {
-        testport = port ? port : rand() % ((mFinish - mStart) / 2) * 2 + mStart;
-
-        switch (family)
+        int on = 1;
+        ::setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (const char*)&on, sizeof on);
+    }
+#endif
+    switch (family)
+    {
+    case AF_INET:
         {
-        case AF_INET:
+            sockaddr_in addr;
             memset(&addr, 0, sizeof addr);
             addr.sin_family = AF_INET;
-            addr.sin_port = htons(testport);
+            addr.sin_port = htons(port);
             result = ::bind(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof addr);
-            if (result)
-                result = WSAGetLastError();
-            break;
+        }
+        break;
 
-        case AF_INET6:
+    case AF_INET6:
+        {
+            sockaddr_in6 addr6;
             memset(&addr6, 0, sizeof addr6);
             addr6.sin6_family = AF_INET6;
-            addr6.sin6_port = htons(testport);
+            addr6.sin6_port = htons(port);
             result = ::bind(sock, reinterpret_cast<const sockaddr*>(&addr6), sizeof addr6);
-            if (result)
-                result = WSAGetLastError();
-            break;
         }
-
-    } while (result == WSAEADDRINUSE && --attemptsLeft > 0);
+        break;
+    }
 
     if (result)
     {
+        result = WSAGetLastError();
         closesocket(sock);
-        throw Exception(ERR_NET_FAILED, WSAGetLastError());
+        throw Exception(ERR_NET_FAILED, result);
     }
     auto resultObject = std::make_shared<DatagramSocket>();
-    resultObject->mLocalPort = testport;
+    resultObject->mLocalPort = port;
     resultObject->mHandle = sock;
+    resultObject->mShard = shard.mIndex;
     if (!resultObject->setBlocking(false))
     {
+        result = WSAGetLastError();
         resultObject->closeSocket();
-        throw Exception(ERR_NET_FAILED, WSAGetLastError());
+        throw Exception(ERR_NET_FAILED, result);
+    }
+
+    // Port is referenced until socket leaves the map in processDeleted()
+    unsigned recvSize, sendSize;
+    {
+        Lock l(mGuard);
+        mPorts.reserve(port);
+
+        // Sink is counted in shard of its first socket
+        SinkShard& ss = mSinkShards[sink];
+        if (!ss.mSockets++)
+        {
+            ss.mShard = shard.mIndex;
+            shard.mSinks++;
+        }
+
+        recvSize = mRecvBufferSize;
+        sendSize = mSendBufferSize;
     }
+    if ((recvSize || sendSize) && !resultObject->setBufferSizes(recvSize, sendSize))
+        ICELogError(<< "Failed to set socket buffer sizes " << recvSize << "/" << sendSize << " on port " << port << ", error " << WSAGetLastError());
 
-    // Put socket object to the map
-    mSocketMap[sock].mSink = sink;
-    mSocketMap[sock].mSocket = resultObject;
+    // Reactor thread of chosen shard puts socket into its map. Shard lock is held while sinks run,
+    // so taking it here would nest locks of two shards when a sink allocates socket of another shard.
+    {
+        Lock l(shard.mDeleteGuard);
+        SocketItem item;
+        item.mSink = sink;
+        item.mSocket = resultObject;
+        shard.mAddVector.push_back(std::move(item));
+    }
+
+#if defined(HAVE_EPOLL)
+    // Kernel receive timestamps keep socket queueing delay out of jitter;
+    // overflow counter separates local drops from network loss
+    resultObject->enableTimestamps();
+    resultObject->enableDropCounter();
+
+    // Register once; the reactor does not rebuild any set per iteration.
+    // Registration is kept in io_uring mode too so the shard can fall back to epoll.
+    if (shard.mEpoll.isOpened())
+        shard.mEpoll.add(sock);
+#endif
+
+#if defined(HAVE_IO_URING)
+    // Ring is used by reactor thread only - it arms the socket on next iteration
+    if (shard.mRing.isOpened())
+    {
+        Lock l(shard.mDeleteGuard);
+        shard.mArmVector.push_back(resultObject);
+    }
+#endif
 
     return resultObject;
 }
@@ -209,39 +503,104 @@ void SocketHeap::freeSocket(PDatagramSocket socket)
     if (!socket)
         return;
 
-    Lock l(mDeleteGuard);
-    mDeleteVector.push_back(socket);
+    // Virtual socket has no handle - just stop routing data to it
+    if (VirtualDatagramSocket* v = dynamic_cast<VirtualDatagramSocket*>(socket.get()))
+    {
+        v->closeSocket();
+        return;
+    }
+
+    if (socket->mShard >= mShards.size())
+        return;
+
+    Shard& shard = *mShards[socket->mShard];
+    Lock l(shard.mDeleteGuard);
+    shard.mDeleteVector.push_back(socket);
 }
 
-void SocketHeap::processDeleted()
+void SocketHeap::processDeleted(Shard& shard)
 {
-    Lock l(mDeleteGuard);
+    Lock l(shard.mDeleteGuard);
 
-    SocketVector::iterator socketIter = mDeleteVector.begin();
-    while (socketIter != mDeleteVector.end())
+    // Sockets created since last call; added first as they may be in mDeleteVector already
+    for (SocketItem& item: shard.mAddVector)
+        shard.mSocketMap[item.mSocket->mHandle] = std::move(item);
+    shard.mAddVector.clear();
+
+    SocketVector::iterator socketIter = shard.mDeleteVector.begin();
+    while (socketIter != shard.mDeleteVector.end())
     {
         // Find socket to delete in main socket map
-        SocketMap::iterator itemIter = mSocketMap.find((*socketIter)->mHandle);
+        SocketMap::iterator itemIter = shard.mSocketMap.find((*socketIter)->mHandle);
 
-        if (itemIter != mSocketMap.end())
+        if (itemIter != shard.mSocketMap.end())
         {
+#if defined(HAVE_IO_URING)
+            // Multishot receive holds its own reference to socket - it would keep port bound after close
+            if (itemIter->second.mRingTag)
+                shard.mRing.cancel(itemIter->first);
+#endif
+#if defined(HAVE_EPOLL)
+            // Stop watching socket before the last reference to it (and so the handle) can go away
+            if (shard.mEpoll.isOpened())
+                shard.mEpoll.remove(itemIter->first);
+#endif
+            // Port pair becomes free when all its sockets are gone
+            {
+                Lock portLock(mGuard);
+                mPorts.release((*socketIter)->mLocalPort);
+
+                auto sinkIter = mSinkShards.find(itemIter->second.mSink);
+                if (sinkIter != mSinkShards.end() && !--sinkIter->second.mSockets)
+                {
+                    mShards[sinkIter->second.mShard]->mSinks--;
+                    mSinkShards.erase(sinkIter);
+                }
+            }
+
             // If found - delete socket object from map
-            mSocketMap.erase(itemIter);
+            shard.mSocketMap.erase(itemIter);
         }
 
         socketIter++;
     }
 
-    mDeleteVector.clear();
+    shard.mDeleteVector.clear();
 }
 
-void SocketHeap::thread()
+void SocketHeap::receiveFrom(Shard& shard, const PDatagramSocket& sock, SocketSink* sink)
 {
-    /*#ifdef __linux__
-    // TODO: make epoll implementation for massive polling
-#else*/
-    mThreadId = std::this_thread::get_id();
+    // Single recvmmsg() call instead of syscall per datagram
+    if (sock->recvDatagrams(shard.mRecvBatch) > 0)
+    {
+        if (shard.mRecvBatch.drops())
+            mLocalDrops += shard.mRecvBatch.drops();
+        sink->onReceivedBatch(sock, shard.mRecvBatch);
+    }
+}
 
+void SocketHeap::thread(Shard& shard)
+{
+    shard.mThreadId = std::this_thread::get_id();
+
+#if defined(HAVE_IO_URING)
+    // Returns when ring fails; remaining time of shard is served by epoll
+    if (shard.mRing.isOpened())
+        threadUring(shard);
+    if (isShutdown())
+        return;
+#endif
+
+#if defined(HAVE_EPOLL)
+    if (shard.mEpoll.isOpened())
+        threadEpoll(shard);
+    else
+#endif
+        threadSelect(shard);
+}
+
+void SocketHeap::threadSelect(Shard& shard)
+{
     while (!isShutdown())
     {
         // Define socket agreggator
@@ -249,22 +608,16 @@ void SocketHeap::thread()
 
         // Make a protected copy of sockets
         {
-            Lock l(mGuard);
+            Lock l(shard.mGuard);
 
             // Remove deleted sockets from map and close them
             {
-                processDeleted();
+                processDeleted(shard);
             }
 
             // Update socket set
-            for (auto& socketIter: mSocketMap)
+            for (auto& socketIter: shard.mSocketMap)
                 agreggator.addSocket(socketIter.second.mSocket);
-
-            /*      for (SocketMap::iterator socketIter = mSocketMap.begin(); socketIter != mSocketMap.end(); ++socketIter)
-      {
-        // Add handle to set
-        agreggator.addSocket(socketIter->second.mSocket);
-      } */
         }
 
         // If set is not empty
@@ -273,32 +626,25 @@ void SocketHeap::thread()
             if (agreggator.waitForData(10ms))
             {
                 ICELogMedia(<< "There is data on UDP sockets");
-                Lock l(mGuard);
+                Lock l(shard.mGuard);
 
                 // Remove deleted sockets to avoid call non-existant sinks
-                processDeleted();
+                processDeleted(shard);
 
                 for (unsigned i=0; i<agreggator.count(); i++)
                 {
                     if (agreggator.hasDataAtIndex(i))
                     {
-                        //ICELogInfo(<<"Got incoming UDP packet at index " << (const int)i);
                         PDatagramSocket sock = agreggator.socketAt(i);
 
                         // Find corresponding data sink
-                        SocketMap::iterator socketItemIter = mSocketMap.find(sock->mHandle);
+                        SocketMap::iterator socketItemIter = shard.mSocketMap.find(sock->mHandle);
 
-                        if (socketItemIter != mSocketMap.end())
-                        {
-                            InternetAddress src;
-                            unsigned received = sock->recvDatagram(src, mTempPacket, sizeof mTempPacket);
-
-                            if ( received > 0 && received <= MAX_VALID_UDPPACKET_SIZE)
-                                socketItemIter->second.mSink->onReceivedData(sock, src, mTempPacket, received);
-                        }
+                        if (socketItemIter != shard.mSocketMap.end())
+                            receiveFrom(shard, sock, socketItemIter->second.mSink);
 
                         // There is a call to ProcessDeleted() as OnReceivedData() could delete sockets
-                        processDeleted();
+                        processDeleted(shard);
                     }
                 } //of for
             }
@@ -306,11 +652,163 @@ void SocketHeap::thread()
         else
             std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
+}
 
-    mShutdown = false;
-    //#endif
+void SocketHeap::threadEpoll(Shard& shard)
+{
+#if defined(HAVE_EPOLL)
+    while (!isShutdown())
+    {
+        // Waiting is done without lock - allocSocket()/freeSocket() may update epoll set meanwhile.
+        // The cost of wakeup depends on number of ready sockets only.
+        int ready = shard.mEpoll.wait(10ms);
+
+        Lock l(shard.mGuard);
+
+        // Remove deleted sockets to avoid call non-existant sinks
+        processDeleted(shard);
+
+        for (int i=0; i<ready; i++)
+        {
+            SocketMap::iterator socketItemIter = shard.mSocketMap.find(shard.mEpoll.readyAt(i));
+            if (socketItemIter == shard.mSocketMap.end())
+                continue;
+
+            // Keep socket alive while sink is running - sink can free it
+            PDatagramSocket sock = socketItemIter->second.mSocket;
+            SocketSink* sink = socketItemIter->second.mSink;
+
+            // Level triggered mode - datagrams above batch capacity will be reported on next wait
+            receiveFrom(shard, sock, sink);
+
+            // There is a call to ProcessDeleted() as OnReceivedData() could delete sockets
+            processDeleted(shard);
+        }
+    }
+#endif
+}
+
+#if defined(HAVE_IO_URING)
+// Delivers io_uring completions of one shard; called with shard lock held
+class SocketHeap::RingHandler: public IoUring::Handler
+{
+public:
+    RingHandler(SocketHeap& heap, Shard& shard)
+        :mHeap(heap), mShard(shard)
+    {}
+
+    void onDatagram(const IoUring::Datagram& d) override
+    {
+        SocketMap::iterator iter = mShard.mSocketMap.find(static_cast<SOCKET>(d.mTag & 0xFFFFFFFF));
+        if (iter == mShard.mSocketMap.end() || iter->second.mRingTag != d.mTag || d.mTruncated)
+            return;
+
+        // Keep socket alive while sink is running - sink can free it
+        PDatagramSocket sock = iter->second.mSocket;
+        SocketSink* sink = iter->second.mSink;
+
+        unsigned drops = 0;
+        DatagramTime receiveTime = sock->parseControl(d.mHeader, std::chrono::system_clock::now(), drops);
+        if (drops)
+            mHeap.mLocalDrops += drops;
+
+        InternetAddress src(*reinterpret_cast<const sockaddr*>(d.mHeader.msg_name), d.mHeader.msg_namelen);
+        sink->onReceivedData(sock, src, d.mData, d.mSize, receiveTime);
+
+        // Sink could free sockets
+        mHeap.processDeleted(mShard);
+    }
+
+    void onReceiveStopped(uint64_t tag, int error) override
+    {
+        SocketMap::iterator iter = mShard.mSocketMap.find(static_cast<SOCKET>(tag & 0xFFFFFFFF));
+        if (iter == mShard.mSocketMap.end() || iter->second.mRingTag != tag)
+            return;
+        iter->second.mRingTag = 0;
+
+        switch (error)
+        {
+        case 0:
+        case -ENOBUFS:      // Buffer ring was exhausted for a moment
+        case -EINTR:
+        case -EAGAIN:
+            mHeap.armSocket(mShard, iter->first, iter->second);
+            break;
+
+        default:
+            // -EINVAL means kernel without multishot recvmsg (before 6.0)
+            ICELogError(<< "io_uring receive stopped on socket " << iter->first << ", error " << -error << "; switching shard " << mShard.mIndex << " to epoll");
+            mFailed = true;
+        }
+    }
+
+    bool failed() const { return mFailed; }
+
+protected:
+    SocketHeap& mHeap;
+    Shard&      mShard;
+    bool        mFailed = false;
+};
+
+void SocketHeap::armSocket(Shard& shard, SOCKET s, SocketItem& item)
+{
+    // Tag carries generation so completions of closed socket are not taken for the new one reusing the handle
+    uint64_t tag = (uint64_t(++shard.mRingGeneration) << 32) | static_cast<uint32_t>(s);
+    if (shard.mRing.recvMultishot(s, tag))
+        item.mRingTag = tag;
 }
 
+void SocketHeap::armPending(Shard& shard)
+{
+    SocketVector pending;
+    {
+        Lock l(shard.mDeleteGuard);
+        pending.swap(shard.mArmVector);
+    }
+
+    for (auto& sock: pending)
+    {
+        SocketMap::iterator iter = shard.mSocketMap.find(sock->socket());
+        if (iter != shard.mSocketMap.end() && iter->second.mSocket == sock && !iter->second.mRingTag)
+            armSocket(shard, iter->first, iter->second);
+    }
+}
+#endif
+
+void SocketHeap::threadUring(Shard& shard)
+{
+#if defined(HAVE_IO_URING)
+    RingHandler handler(*this, shard);
+
+    while (!isShutdown() && !handler.failed())
+    {
+        // Waiting is done without lock; new sockets are queued to mArmVector meanwhile
+        if (!shard.mRing.wait(10ms))
+            break;
+
+        Lock l(shard.mGuard);
+
+        // Remove deleted sockets first - it cancels their receives
+        processDeleted(shard);
+        shard.mRing.reap(handler);
+        processDeleted(shard);
+        armPending(shard);
+    }
+
+    if (!isShutdown())
+    {
+        // Epoll registrations are in place, so the shard continues with epoll
+        Lock l(shard.mGuard);
+        for (auto& item: shard.mSocketMap)
+        {
+            if (item.second.mRingTag)
+                shard.mRing.cancel(item.first);
+            item.second.mRingTag = 0;
+        }
+        shard.mRing.close();
+    }
+#endif
+}
 
 static SocketHeap GRTPSocketHeap(20002, 25100);
 SocketHeap& SocketHeap::instance()
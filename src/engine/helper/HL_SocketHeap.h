@@ -12,17 +12,29 @@
 #include <algorithm>
 
 #include <thread>
+#include <memory>
+#include <atomic>
 
 #include "HL_NetworkSocket.h"
 #include "HL_Sync.h"
 #include "HL_Rtp.h"
+#include "HL_Epoll.h"
+#include "HL_IoUring.h"
+#include "HL_PortAllocator.h"
+
+class DatagramMux;
 
 // Class is used to process incoming datagrams
 class SocketSink
 {
 public:
     virtual ~SocketSink();
-    virtual void onReceivedData(PDatagramSocket socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize) = 0;
+    // receiveTime is kernel timestamp of datagram when available
+    virtual void onReceivedData(PDatagramSocket socket, InternetAddress& src, const void* receivedPtr, unsigned receivedSize, DatagramTime receiveTime) = 0;
+
+    // Called with burst of datagrams read from single socket. Default implementation calls onReceivedData() for each one;
+    // sinks can override it to process the whole burst under single lock.
+    virtual void onReceivedBatch(PDatagramSocket socket, DatagramBatch& batch);
 };
 
 // Class allocates new UDP sockets and tracks incoming packets on them. It runs in separate thread
@@ -49,9 +61,50 @@ public:
     // Returns used port number range
     void range(unsigned short& start, unsigned short& finish);
 
-    // Attempts to allocate and return socket + allocated port number. REQUIRES pointer to data sink - it will be used to process incoming datagrams
-    PDatagramSocket allocSocket(int family, SocketSink* sink, int port = 0);
-    RtpPair<PDatagramSocket> allocSocketPair(int family, SocketSink* sink,  Multiplex m);
+    // Returns port pair usage inside range
+    PortAllocator::Usage portUsage();
+
+    // Sets SO_RCVBUF / SO_SNDBUF for sockets created later; zero keeps system default.
+    // Kernel may clamp the values (net.core.rmem_max / wmem_max).
+    void setBufferSizes(unsigned recvSize, unsigned sendSize);
+    void bufferSizes(unsigned& recvSize, unsigned& sendSize);
+
+    // Total number of datagrams dropped by kernel on heap sockets because receive queues overflowed.
+    // These are local drops - they are not network loss.
+    uint64_t localDrops() const;
+
+    // Enables single port mode: all media sockets allocated later are virtual sockets sharing
+    // 'carriers' UDP sockets bound to this port (SO_REUSEPORT is used for several carriers).
+    // RTP and RTCP always share one socket in this mode. Port 0 switches back to socket per stream.
+    // Kernel picks carrier by address hash, so all carriers are served by one shard - datagrams of
+    // a session arriving on different carriers are never dispatched concurrently.
+    void setMultiplexPort(unsigned short port, unsigned carriers = 1);
+    unsigned short multiplexPort();
+    DatagramMux& mux();
+
+    // Sets number of reactor threads (shards). Every shard has own socket map, lock and thread,
+    // so sinks living in different shards receive data in parallel. Has effect only before start(); default is 1.
+    void setShardCount(unsigned count);
+    unsigned shardCount() const;
+
+    // Allows io_uring reactor (multishot receive into shared buffer ring). It is used only if library is
+    // built with USE_IO_URING and kernel supports it; otherwise epoll/select are used. Has effect only before start(); default is true.
+    void setIoUring(bool enabled);
+
+    // Returns number of shards currently served by io_uring reactor
+    unsigned ioUringShards() const;
+
+    // Returns shard used by default for sockets of specified sink - the one already serving this sink,
+    // otherwise the shard with fewest sinks. All sockets of one sink (e.g. RTP/RTCP pairs of single session)
+    // end up in the same shard and so are never served concurrently.
+    unsigned shardFor(SocketSink* sink);
+
+    // Attempts to allocate and return socket + allocated port number. REQUIRES pointer to data sink - it will be used to process incoming datagrams.
+    // Shard is chosen by shardFor(sink) when shard is negative.
+    PDatagramSocket allocSocket(int family, SocketSink* sink, int port = 0, int shard = -1);
+
+    // Both sockets of pair are always placed into the same shard
+    RtpPair<PDatagramSocket> allocSocketPair(int family, SocketSink* sink,  Multiplex m, int shard = -1);
 
     // Stops receiving data for specified socket and frees socket itself.
     void freeSocket(PDatagramSocket socket);
@@ -69,6 +122,9 @@ protected:
         // Data sink pointer
         SocketSink* mSink;
 
+        // Tag of multishot receive armed for socket in io_uring reactor (0 - not armed)
+        uint64_t mRingTag = 0;
+
         SocketItem()
             :mSink(nullptr)
         { }
@@ -84,29 +140,91 @@ protected:
     };
 
     typedef std::map<SOCKET, SocketItem> SocketMap;
-    typedef std::vector<unsigned short> PortVector;
     typedef std::vector<PDatagramSocket> SocketVector;
 
-    Mutex           mGuard;
-    SocketMap       mSocketMap;
-    PortVector      mPortVector;
+    // Reactor serving subset of sockets
+    struct Shard
+    {
+        unsigned        mIndex = 0;
+        unsigned        mSinks = 0;         // Number of sinks having sockets here; protected by SocketHeap::mGuard
+        Mutex           mGuard;             // Held while sinks of this shard are running; taken by reactor thread only
+        SocketMap       mSocketMap;
+        std::vector<SocketItem> mAddVector; // New sockets waiting for reactor thread (under mDeleteGuard)
+        SocketVector    mDeleteVector;
+        Mutex           mDeleteGuard;
+        DatagramBatch   mRecvBatch;         // Reusable buffers for incoming datagrams
+
+#if defined(HAVE_EPOLL)
+        // Sockets are registered here in allocSocket() and removed in processDeleted()
+        Epoll           mEpoll;
+#endif
+#if defined(HAVE_IO_URING)
+        // Opened in start() when io_uring is usable; sockets wait in mArmVector (under mDeleteGuard)
+        // until reactor thread arms them. Epoll registration is kept as fallback.
+        IoUring         mRing;
+        SocketVector    mArmVector;
+        uint32_t        mRingGeneration = 0;
+#endif
+        std::shared_ptr<std::thread> mWorkerThread;
+        std::thread::id mThreadId;
+    };
+    typedef std::vector<std::unique_ptr<Shard>> ShardVector;
+
+    // Shard serving sink and number of its sockets
+    struct SinkShard
+    {
+        unsigned        mShard = 0;
+        unsigned        mSockets = 0;
+    };
+    typedef std::map<SocketSink*, SinkShard> SinkShardMap;
+
+    Mutex           mGuard;             // Protects port range and allocator
     unsigned short  mStart,
     mFinish;
-    SocketVector    mDeleteVector;
-    Mutex           mDeleteGuard;
+    PortAllocator   mPorts;
+    unsigned        mRecvBufferSize = 0,
+                    mSendBufferSize = 0;
+    std::atomic<uint64_t> mLocalDrops = 0;
+    unsigned short  mMuxPort = 0;
+    unsigned        mMuxCarriers = 1;
+    std::unique_ptr<DatagramMux> mMux;
+    Mutex           mMuxGuard;          // Serializes carrier creation; taken before any other lock
+    ShardVector     mShards;
+    SinkShardMap    mSinkShards;        // Protected by mGuard
+
+    bool            mUseIoUring = true;
+    std::atomic_bool mShutdown = false;
+    bool isShutdown() const { return mShutdown; }
 
-    char            mTempPacket[MAX_UDPPACKET_SIZE];
+    Shard& shardAt(int index, SocketSink* sink);
 
-    std::shared_ptr<std::thread> mWorkerThread;
+    // Creates socket bound to specified port and queues it for shard. Throws Exception(ERR_NET_FAILED, error code) on failure.
+    // Shard lock is not taken - sinks may allocate sockets of other shards from their callbacks.
+    PDatagramSocket createSocket(int family, SocketSink* sink, unsigned short port, Shard& shard, bool reusePort = false);
 
-    std::thread::id mThreadId;
-    bool mShutdown = false;
-    bool isShutdown() const { return mShutdown; }
+    // Returns virtual socket in single port mode; creates carriers for family on first call
+    PDatagramSocket createVirtualSocket(int family, SocketSink* sink);
+
+    void thread(Shard& shard);
+
+    // Reactor loops. io_uring one is preferred, epoll is used when it is unavailable; select() is fallback for other platforms
+    void threadSelect(Shard& shard);
+    void threadEpoll(Shard& shard);
+    void threadUring(Shard& shard);
+
+#if defined(HAVE_IO_URING)
+    class RingHandler;
+
+    // Arms sockets queued in mArmVector
+    void armPending(Shard& shard);
+    void armSocket(Shard& shard, SOCKET s, SocketItem& item);
+#endif
 
-    void thread();
+    // Moves mAddVector items into mSocketMap, then processes mDeleteVector -> removes socket items and closes sockets specified in mDeleteVector
+    void processDeleted(Shard& shard);
 
-    // Processes mDeleteVector -> updates mSocketMap, removes socket items and closes sockets specified in mDeleteVector
-    void processDeleted();
+    // Reads pending datagrams from socket and passes them to sink
+    void receiveFrom(Shard& shard, const PDatagramSocket& sock, SocketSink* sink);
 
 };
 
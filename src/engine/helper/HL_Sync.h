@@ -6,6 +6,7 @@
 #ifndef __HL_SYNC_H
 #define __HL_SYNC_H
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
@@ -101,6 +102,60 @@ protected:
 };
 
 
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Capacity is rounded up to power of two. push() fails when queue is full - producer never waits.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mItems.resize(size);
+        mMask = size - 1;
+    }
+
+    // Producer side
+    bool push(T&& item)
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) > mMask)
+            return false;
+
+        mItems[tail & mMask] = std::move(item);
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& item)
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire))
+            return false;
+
+        item = std::move(mItems[head & mMask]);
+        mItems[head & mMask] = T();
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+
+protected:
+    std::vector<T> mItems;
+    size_t mMask = 0;
+
+    // Separate cache lines - producer and consumer do not invalidate each other
+    alignas(64) std::atomic<size_t> mHead = 0;
+    alignas(64) std::atomic<size_t> mTail = 0;
+};
+
 // Timer Queue
 //
 // Allows execution of handlers at a specified time in the future
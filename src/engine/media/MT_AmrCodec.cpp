@@ -6,6 +6,8 @@
 #include "../helper/HL_IuUP.h"
 #include "../helper/HL_Log.h"
 
+#include <algorithm>
+
 #define LOG_SUBSYSTEM "media"
 using namespace MT;
 
@@ -54,6 +56,23 @@ struct AmrPayload
     bool                  mDiscardPacket = false;
 };
 
+// Number of frames in AMR RTP payload - it is number of table of contents entries.
+// Used to reserve output before payload is parsed; parsing changes decoder state.
+static size_t amrFrameCount(std::span<const uint8_t> payload, bool octetAligned)
+{
+    size_t bits = payload.size() * 8, position = octetAligned ? 8 : 4, result = 0;
+    while (position < bits)
+    {
+        result++;
+
+        // F bit starts every TOC entry
+        if (!(payload[position / 8] & (0x80 >> (position % 8))))
+            break;
+        position += octetAligned ? 8 : 6;
+    }
+    return std::max<size_t>(result, 1);
+}
+
 // ARM RTP payload has next structure
 //   Header
 //   Table of Contents
@@ -441,6 +460,24 @@ Codec::DecodeResult AmrNbCodec::decode(std::span<const uint8_t> input, std::span
     return {.mDecoded = (size_t)pcmLength()};
 }
 
+size_t AmrNbCodec::decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results)
+{
+    ensureDecoder();
+
+    size_t count = std::min(inputs.size(), results.size()), offset = 0, i = 0;
+    for (; i < count; i++)
+    {
+        // IuUP frame and empty (PLC) payload produce single frame
+        size_t frames = mConfig.mIuUP || inputs[i].empty() ? 1 : amrFrameCount(inputs[i], mConfig.mOctetAligned);
+        if (output.size() - offset < frames * pcmLength())
+            break;
+
+        results[i] = AmrNbCodec::decode(inputs[i], output.subspan(offset));
+        offset += results[i].mDecoded;
+    }
+    return i;
+}
+
 size_t AmrNbCodec::plc(int lostFrames, std::span<uint8_t> output)
 {
     ensureDecoder();
@@ -663,6 +700,23 @@ Codec::DecodeResult AmrWbCodec::decode(std::span<const uint8_t> input, std::span
         return decodePlain(input, output);
 }
 
+size_t AmrWbCodec::decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results)
+{
+    ensureDecoder();
+
+    size_t count = std::min(inputs.size(), results.size()), offset = 0, i = 0;
+    for (; i < count; i++)
+    {
+        size_t frames = mConfig.mIuUP || inputs[i].empty() ? 1 : amrFrameCount(inputs[i], mConfig.mOctetAligned);
+        if (output.size() - offset < frames * pcmLength())
+            break;
+
+        results[i] = mConfig.mIuUP ? decodeIuup(inputs[i], output.subspan(offset)) : decodePlain(inputs[i], output.subspan(offset));
+        offset += results[i].mDecoded;
+    }
+    return i;
+}
+
 size_t AmrWbCodec::plc(int lostFrames, std::span<uint8_t> output)
 {
     // ToDo: Check again if PLC works for AMR-WB
@@ -67,6 +67,7 @@ public:
 
     EncodeResult encode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
     DecodeResult decode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
+    size_t decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results) override;
     size_t plc(int lostFrames, std::span<uint8_t> output) override;
 
     int getSwitchCounter() const;
@@ -126,6 +127,7 @@ public:
 
     EncodeResult encode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
     DecodeResult decode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
+    size_t       decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results) override;
     size_t       plc(int lostFrames, std::span<uint8_t> output) override;
     int getSwitchCounter() const;
     int getCngCounter() const;
@@ -6,6 +6,8 @@
 #include "../engine_config.h"
 #include "MT_AudioCodec.h"
 #include "MT_CodecList.h"
+#include "MT_CodecStatePool.h"
+#include "MT_G711.h"
 #include "../helper/HL_Exception.h"
 #include "../helper/HL_Types.h"
 #include "../helper/HL_String.h"
@@ -210,6 +212,48 @@ size_t G729Codec::plc(int lostFrames, std::span<uint8_t> output)
 #define OPUS_PACKET_LOSS        10
 #define OPUS_CODEC_COMPLEXITY   2
 
+// Opus states are pooled - see CodecStatePool; key is samplerate and channels
+static int opusStateKey(int samplerate, int channels)
+{
+    return samplerate * 10 + channels;
+}
+
+static const CodecStatePool::StateType OpusDecoderState =
+{
+    .mName      = "Opus decoder",
+    .mCreate    = [](int key) -> void*
+    {
+        int status = 0;
+        return opus_decoder_create(key / 10, key % 10, &status);
+    },
+    .mReset     = [](void* state, int) { opus_decoder_ctl((OpusDecoder*)state, OPUS_RESET_STATE); },
+    .mDestroy   = [](void* state) { opus_decoder_destroy((OpusDecoder*)state); }
+};
+
+static const CodecStatePool::StateType OpusEncoderState =
+{
+    .mName      = "Opus encoder",
+    .mCreate    = [](int key) -> void*
+    {
+        int status = 0;
+        OpusEncoder* encoder = opus_encoder_create(key / 10, key % 10, OPUS_APPLICATION_VOIP, &status);
+        if (encoder && OPUS_OK != opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(OPUS_CODEC_COMPLEXITY)))
+            ICELogError(<< "Failed to set Opus encoder complexity");
+        return encoder;
+    },
+    .mReset     = [](void* state, int)
+    {
+        // Reset keeps settings - return the ones OpusCodec::applyParams() changes to defaults
+        OpusEncoder* encoder = (OpusEncoder*)state;
+        opus_encoder_ctl(encoder, OPUS_RESET_STATE);
+        opus_encoder_ctl(encoder, OPUS_SET_DTX(0));
+        opus_encoder_ctl(encoder, OPUS_SET_INBAND_FEC(0));
+        opus_encoder_ctl(encoder, OPUS_SET_BITRATE(OPUS_AUTO));
+        opus_encoder_ctl(encoder, OPUS_SET_PACKET_LOSS_PERC(0));
+    },
+    .mDestroy   = [](void* state) { opus_encoder_destroy((OpusEncoder*)state); }
+};
+
 OpusCodec::Params::Params()
     :mUseDtx(false), mUseInbandFec(true), mStereo(true), mPtime(20)
 {
@@ -330,6 +374,7 @@ int OpusCodec::OpusFactory::payloadType()
 void OpusCodec::OpusFactory::updateSdp(resip::SdpContents::Session::Medium::CodecContainer& codecs, SdpDirection direction)
 {
     // Put opus codec record
+    std::unique_lock<std::mutex> l(mGuard);
     resip::Codec opus(name(), payloadType(), samplerate());
     if (mParams.mStereo)
         opus.encodingParameters() = "2";
@@ -351,6 +396,7 @@ int OpusCodec::OpusFactory::processSdp(const resip::SdpContents::Session::Medium
         // Accept only 48000Hz configurations
         if (stricmp(resipCodec.getName().c_str(), name()) == 0 && resipCodec.getRate() == 48000)
         {
+            std::unique_lock<std::mutex> l(mGuard);
             mParams.parse(resipCodec.parameters());
 
             // Check number of channels
@@ -359,9 +405,9 @@ int OpusCodec::OpusFactory::processSdp(const resip::SdpContents::Session::Medium
             // Here changes must be applied to instantiated codec
             for (CodecList::iterator instanceIter = mCodecList.begin(); instanceIter != mCodecList.end(); ++instanceIter)
             {
-                Codec& c = **instanceIter;
-                if ((c.channels() == (mParams.mStereo ? 2 : 1)) && resipCodec.getRate() == c.samplerate())
-                    dynamic_cast<OpusCodec&>(c).applyParams(mParams);
+                PCodec c = instanceIter->lock();
+                if (c && (c->channels() == (mParams.mStereo ? 2 : 1)) && resipCodec.getRate() == c->samplerate())
+                    dynamic_cast<OpusCodec&>(*c).applyParams(mParams);
             }
             return codecIter->payloadType();
         }
@@ -371,9 +417,14 @@ int OpusCodec::OpusFactory::processSdp(const resip::SdpContents::Session::Medium
 
 PCodec OpusCodec::OpusFactory::create()
 {
+    std::unique_lock<std::mutex> l(mGuard);
     OpusCodec* result = new OpusCodec(Audio::Format(mSamplerate, mChannels), mParams.mPtime);
     result->applyParams(mParams);
     PCodec c(result);
+
+    // Forget destroyed codecs - factory may live as long as the process
+    mCodecList.erase(std::remove_if(mCodecList.begin(), mCodecList.end(), [](const std::weak_ptr<Codec>& w) { return w.expired(); }),
+                     mCodecList.end());
     mCodecList.push_back(c);
 
     return c;
@@ -382,10 +433,7 @@ PCodec OpusCodec::OpusFactory::create()
 OpusCodec::OpusCodec(Audio::Format fmt, int ptime)
     :mEncoderCtx(nullptr), mDecoderCtx(nullptr), mChannels(fmt.channels()), mPTime(ptime), mSamplerate(fmt.rate()), mDecoderChannels(0)
 {
-    int status;
-    mEncoderCtx = opus_encoder_create(mSamplerate, mChannels, OPUS_APPLICATION_VOIP, &status);
-    if (OPUS_OK != opus_encoder_ctl(mEncoderCtx, OPUS_SET_COMPLEXITY(OPUS_CODEC_COMPLEXITY)))
-        ICELogError(<< "Failed to set Opus encoder complexity");
+    mEncoderCtx = (OpusEncoder*)CodecStatePool::instance().acquire(OpusEncoderState, opusStateKey(mSamplerate, mChannels));
     // Decoder creation is postponed until first packet arriving (because it may use different channel number
 }
 
@@ -411,13 +459,13 @@ OpusCodec::~OpusCodec()
 {
     if (mDecoderCtx)
     {
-        opus_decoder_destroy(mDecoderCtx);
+        CodecStatePool::instance().release(OpusDecoderState, mDecoderCtx, opusStateKey(mSamplerate, mDecoderChannels));
         mDecoderCtx = nullptr;
     }
 
     if (mEncoderCtx)
     {
-        opus_encoder_destroy(mEncoderCtx);
+        CodecStatePool::instance().release(OpusEncoderState, mEncoderCtx, opusStateKey(mSamplerate, mChannels));
         mEncoderCtx = nullptr;
     }
 }
@@ -460,7 +508,7 @@ Codec::DecodeResult OpusCodec::decode(std::span<const uint8_t> input, std::span<
     {
         if (mDecoderCtx)
         {
-            opus_decoder_destroy(mDecoderCtx);
+            CodecStatePool::instance().release(OpusDecoderState, mDecoderCtx, opusStateKey(mSamplerate, mDecoderChannels));
             mDecoderCtx = nullptr;
         }
         mDecoderChannels = nr_of_channels;
@@ -468,9 +516,8 @@ Codec::DecodeResult OpusCodec::decode(std::span<const uint8_t> input, std::span<
 
     if (!mDecoderCtx)
     {
-        int status = 0;
-        mDecoderCtx = opus_decoder_create(mSamplerate, mDecoderChannels, &status);
-        if (status)
+        mDecoderCtx = (OpusDecoder*)CodecStatePool::instance().acquire(OpusDecoderState, opusStateKey(mSamplerate, mDecoderChannels));
+        if (!mDecoderCtx)
             return {0};
     }
 
@@ -521,6 +568,83 @@ Codec::DecodeResult OpusCodec::decode(std::span<const uint8_t> input, std::span<
     }
 }
 
+size_t OpusCodec::decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results)
+{
+    size_t count = std::min(inputs.size(), results.size()), offset = 0, i = 0;
+    for (; i < count; i++)
+    {
+        std::span<const uint8_t> input = inputs[i];
+        std::span<uint8_t> rest = output.subspan(offset);
+
+        // Duration is known from TOC without decoder; stop before packet which does not fit
+        int nr_of_frames = input.empty() ? 0 : opus_packet_get_nb_samples(input.data(), input.size_bytes(), mSamplerate);
+        if (nr_of_frames > 0 && (size_t)nr_of_frames * sizeof(opus_int16) * channels() > rest.size_bytes())
+            break;
+
+        // Decoder is ready and packet has negotiated channels - decode in place without any setup
+        if (nr_of_frames > 0 && mDecoderCtx && mDecoderChannels == channels() && opus_packet_get_nb_channels(input.data()) == mDecoderChannels)
+        {
+            int decoded = opus_decode(mDecoderCtx, input.data(), input.size_bytes(), (opus_int16*)rest.data(), nr_of_frames, 0);
+            if (decoded < 0)
+                ICELogCritical(<< "opus_decode() returned " << decoded);
+            results[i] = {.mDecoded = decoded > 0 ? (size_t)decoded * sizeof(opus_int16) * mDecoderChannels : 0};
+        }
+        else
+            results[i] = OpusCodec::decode(input, rest);
+
+        offset += results[i].mDecoded;
+    }
+    return i;
+}
+
+size_t OpusCodec::decodeFec(std::span<const uint8_t> input, std::span<uint8_t> output)
+{
+    // FEC continues decoder state - nothing to recover before the first decoded packet
+    if (input.empty() || !mDecoderCtx || (mDecoderChannels != 1 && mDecoderChannels != 2))
+        return 0;
+
+    if (opus_packet_has_lbrr(input.data(), input.size_bytes()) != 1)
+        return 0;
+
+    // LBRR data describes single frame of the lost packet's duration - assume it matches the negotiated packet time
+    size_t packet_bytes = (size_t)pcmLength();
+    int samples_per_packet = (int)(packet_bytes / (sizeof(opus_int16) * channels()));
+    if (samples_per_packet <= 0 || packet_bytes > output.size_bytes())
+        return 0;
+
+    opus_int16* out = reinterpret_cast<opus_int16*>(output.data());
+    if (mDecoderChannels == channels())
+    {
+        // Decoder produces negotiated layout - no conversion needed
+        int decoded = opus_decode(mDecoderCtx, input.data(), input.size_bytes(), out, samples_per_packet, 1);
+        return decoded > 0 ? (size_t)decoded * sizeof(opus_int16) * channels() : 0;
+    }
+
+    // Channel count differs from the negotiated one - decode to a temporary buffer and convert
+    std::vector<opus_int16> temp((size_t)samples_per_packet * mDecoderChannels);
+    int decoded = opus_decode(mDecoderCtx, input.data(), input.size_bytes(), temp.data(), samples_per_packet, 1);
+    if (decoded <= 0)
+        return 0;
+
+    if (channels() == 2 && mDecoderChannels == 1)
+    {
+        for (int i = 0; i < decoded; i++)
+            out[i * 2] = out[i * 2 + 1] = temp[i];
+    }
+    else // mono negotiated, stereo decoder
+    {
+        for (int i = 0; i < decoded; i++)
+            out[i] = (opus_int16)((int(temp[i * 2]) + temp[i * 2 + 1]) / 2);
+    }
+
+    return (size_t)decoded * sizeof(opus_int16) * channels();
+}
+
+bool OpusCodec::hasFec(std::span<const uint8_t> input)
+{
+    return !input.empty() && opus_packet_has_lbrr(input.data(), input.size_bytes()) == 1;
+}
+
 size_t OpusCodec::plc(int lostPackets, std::span<uint8_t> output)
 {
     if (lostPackets <= 0 || output.empty())
@@ -892,34 +1016,50 @@ Codec::Info G711Codec::info() {
 
 Codec::EncodeResult G711Codec::encode(std::span<const uint8_t> input, std::span<uint8_t> output)
 {
-    int result;
+    // One byte per sample
+    size_t samples = std::min(input.size_bytes() / 2, output.size_bytes());
     if (mType == ALaw)
-        result = WebRtcG711_EncodeA(nullptr, (WebRtc_Word16*)input.data(), input.size_bytes() / 2, (WebRtc_Word16*)output.data());
+        G711::encodeALaw(reinterpret_cast<const int16_t*>(input.data()), samples, output.data());
     else
-        result = WebRtcG711_EncodeU(nullptr, (WebRtc_Word16*)input.data(), input.size_bytes() / 2, (WebRtc_Word16*)output.data());
-
-    if (result < 0)
-        return {.mEncoded = 0};
+        G711::encodeULaw(reinterpret_cast<const int16_t*>(input.data()), samples, output.data());
 
-    return {.mEncoded = (size_t) result};
+    return {.mEncoded = samples};
 }
 
 Codec::DecodeResult G711Codec::decode(std::span<const uint8_t> input, std::span<uint8_t> output)
 {
     assert(output.size_bytes() >= input.size_bytes() * 2);
 
-    int result;
-    WebRtc_Word16 speechType;
-
     if (mType == ALaw)
-        result = WebRtcG711_DecodeA(nullptr, (WebRtc_Word16*)input.data(), input.size_bytes(), (WebRtc_Word16*)output.data(), &speechType);
+        G711::decodeALaw(input.data(), input.size_bytes(), reinterpret_cast<int16_t*>(output.data()));
     else
-        result = WebRtcG711_DecodeU(nullptr, (WebRtc_Word16*)input.data(), input.size_bytes(), (WebRtc_Word16*)output.data(), &speechType);
+        G711::decodeULaw(input.data(), input.size_bytes(), reinterpret_cast<int16_t*>(output.data()));
 
-    if (result < 0)
-        return {.mDecoded = 0};
+    return {.mDecoded = input.size_bytes() * 2};
+}
+
+size_t G711Codec::decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results)
+{
+    size_t count = std::min(inputs.size(), results.size()), offset = 0, i = 0;
+    while (i < count && output.size() - offset >= inputs[i].size() * 2)
+    {
+        // Frames of the same RTP payload follow each other in memory - companding kernel runs over them at once
+        const uint8_t* start = inputs[i].data();
+        size_t length = 0;
+        for (; i < count && inputs[i].data() == start + length && output.size() - offset >= (length + inputs[i].size()) * 2; i++)
+        {
+            results[i] = {.mDecoded = inputs[i].size() * 2};
+            length += inputs[i].size();
+        }
 
-    return {.mDecoded = (size_t)result * 2};
+        int16_t* pcm = reinterpret_cast<int16_t*>(output.data() + offset);
+        if (mType == ALaw)
+            G711::decodeALaw(start, length, pcm);
+        else
+            G711::decodeULaw(start, length, pcm);
+        offset += length * 2;
+    }
+    return i;
 }
 
 size_t G711Codec::plc(int lostSamples, std::span<uint8_t> output)
@@ -1129,6 +1269,20 @@ Codec::DecodeResult G722Codec::decode(std::span<const uint8_t> input, std::span<
     return {.mDecoded = (size_t)r};
 }
 
+size_t G722Codec::decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results)
+{
+    // Decoder is sample-by-sample stream - payloads are decoded back to back with single state
+    g722_decode_state_t* state = (g722_decode_state_t *)mDecoder;
+    size_t count = std::min(inputs.size(), results.size()), offset = 0, i = 0;
+    for (; i < count && output.size() - offset >= inputs[i].size() * 4; i++)
+    {
+        int r = g722_decode(state, (short*)(output.data() + offset), (unsigned char*)inputs[i].data(), inputs[i].size()) * 2;
+        results[i] = {.mDecoded = r > 0 ? (size_t)r : 0};
+        offset += results[i].mDecoded;
+    }
+    return i;
+}
+
 size_t G722Codec::plc(int lostFrames, std::span<uint8_t> output)
 {
     if (output.size_bytes() < lostFrames * pcmLength())
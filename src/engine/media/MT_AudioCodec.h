@@ -8,6 +8,7 @@
 
 #include "../engine_config.h"
 #include <map>
+#include <mutex>
 #include "MT_Codec.h"
 #include "../audio/Audio_Resampler.h"
 #include "../helper/HL_Pointer.h"
@@ -89,8 +90,9 @@ public:
     protected:
         int mSamplerate, mChannels, mPType;
         OpusCodec::Params mParams;
-        typedef std::vector<PCodec> CodecList;
-        CodecList mCodecList;
+        typedef std::vector<std::weak_ptr<Codec>> CodecList;
+        CodecList mCodecList;           // Created codecs - they get parameters from processSdp(); not owned
+        std::mutex mGuard;              // Protects mParams and mCodecList; factory may be shared by receivers
 
     public:
         OpusFactory(int samplerate, int channels, int ptype);
@@ -112,7 +114,10 @@ public:
 
     EncodeResult    encode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
     DecodeResult    decode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
+    size_t          decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results) override;
     size_t          plc(int lostFrames, std::span<uint8_t> output) override;
+    size_t          decodeFec(std::span<const uint8_t> input, std::span<uint8_t> output) override;
+    bool            hasFec(std::span<const uint8_t> input) override;
 
     size_t          getNumberOfSamples(std::span<const uint8_t> payload);
 };
@@ -187,6 +192,7 @@ public:
 
     EncodeResult encode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
     DecodeResult decode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
+    size_t       decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results) override;
     size_t       plc(int lostSamples, std::span<uint8_t> output) override ;
 
 protected:
@@ -349,6 +355,7 @@ public:
 
     EncodeResult encode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
     DecodeResult decode(std::span<const uint8_t> input, std::span<uint8_t> output) override;
+    size_t decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results) override;
     size_t plc(int lostFrames, std::span<uint8_t> output) override;
 };
 
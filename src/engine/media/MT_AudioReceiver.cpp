@@ -10,6 +10,7 @@
 #include "MT_Dtmf.h"
 #include "../helper/HL_Log.h"
 #include "../helper/HL_Time.h"
+#include "../helper/HL_RtpMemoryPool.h"
 #include "../audio/Audio_Interface.h"
 #include "../audio/Audio_Resampler.h"
 #include <cmath>
@@ -100,12 +101,70 @@ std::chrono::milliseconds RtpBuffer::prebuffer() const
 int RtpBuffer::getCount() const
 {
     Lock l(mGuard);
-    return static_cast<int>(mPacketList.size());
+    return static_cast<int>(mCount);
 }
 
-bool SequenceSort(const std::shared_ptr<RtpBuffer::Packet>& p1, const std::shared_ptr<RtpBuffer::Packet>& p2)
+std::shared_ptr<RtpBuffer::Packet>& RtpBuffer::slot(uint32_t seqno)
 {
-    return p1->rtp()->GetExtendedSequenceNumber() < p2->rtp()->GetExtendedSequenceNumber();
+    return mRing[seqno & (mRing.size() - 1)];
+}
+
+void RtpBuffer::resize(size_t capacity)
+{
+    PacketRing ring(capacity);
+    if (mCount)
+    {
+        for (uint32_t seqno = mFrontSeqno; seqno != mBackSeqno + 1; seqno++)
+            ring[seqno & (capacity - 1)] = std::move(slot(seqno));
+    }
+    mRing.swap(ring);
+}
+
+void RtpBuffer::insert(const std::shared_ptr<Packet>& p, uint32_t seqno)
+{
+    if (mRing.empty())
+        mRing.resize(RTP_BUFFER_RING_SIZE);
+
+    if (!mCount)
+    {
+        mFrontSeqno = mBackSeqno = seqno;
+    }
+    else
+    {
+        uint32_t front = std::min(mFrontSeqno, seqno),
+                 back = std::max(mBackSeqno, seqno);
+        size_t span = size_t(back - front) + 1;
+        if (span > mRing.size())
+        {
+            size_t capacity = mRing.size();
+            while (capacity < span && capacity < RTP_BUFFER_RING_MAX_SIZE)
+                capacity *= 2;
+            if (capacity != mRing.size())
+                resize(capacity);
+        }
+        mFrontSeqno = front;
+        mBackSeqno = back;
+    }
+
+    slot(seqno) = p;
+    mCount++;
+    mTimelength += p->timelength();
+}
+
+std::shared_ptr<RtpBuffer::Packet> RtpBuffer::popFront()
+{
+    std::shared_ptr<Packet> result = std::move(slot(mFrontSeqno));
+    mCount--;
+    mTimelength -= result->timelength();
+
+    // Skip empty slots left by lost packets
+    if (mCount)
+    {
+        do
+            mFrontSeqno++;
+        while (!slot(mFrontSeqno));
+    }
+    return result;
 }
 
 std::shared_ptr<RtpBuffer::Packet> RtpBuffer::add(const std::shared_ptr<jrtplib::RTPPacket>& packet, std::chrono::milliseconds timelength, int rate)
@@ -115,61 +174,57 @@ std::shared_ptr<RtpBuffer::Packet> RtpBuffer::add(const std::shared_ptr<jrtplib:
 
     Lock l(mGuard);
 
-    // Update statistics
-    if (mLastAddTime == 0.0)
-        mLastAddTime = now_ms();
-    else
-    {
-        float t = now_ms();
-        mStat.mPacketInterval.process(t - mLastAddTime);
-        mLastAddTime = t;
-    }
+    // Update statistics. Receive time of packet is kernel timestamp - reactor delays do not distort the interval
+    double t = packet->GetReceiveTime().GetDouble() * 1000.0;
+    if (mLastAddTime != 0.0)
+        mStat.mPacketInterval.process(static_cast<float>(t - mLastAddTime));
+    mLastAddTime = t;
     mStat.mSsrc = packet->GetSSRC();
 
     // Update jitter
     ICELogMedia(<< "Adding new packet seqno " << packet->GetSequenceNumber() << " into jitter buffer");
     mAddCounter++;
 
-    // Look for maximum&minimal sequence number; check for dublicates
-    unsigned maxno = 0, minno = 0xFFFFFFFF;
-
     // New sequence number
-    unsigned newSeqno = packet->GetExtendedSequenceNumber();
+    uint32_t newSeqno = packet->GetExtendedSequenceNumber();
 
-    for (auto& p: mPacketList)
+    // Check for duplicates - the slot of buffered sequence number holds the same packet
+    if (mCount && newSeqno >= mFrontSeqno && newSeqno <= mBackSeqno)
     {
-        unsigned seqno = p->rtp()->GetExtendedSequenceNumber();
-
-        if (seqno == newSeqno)
+        const auto& existing = slot(newSeqno);
+        if (existing && existing->rtp()->GetExtendedSequenceNumber() == newSeqno)
         {
             mStat.mDuplicatedRtp++;
             ICELogMedia(<< "Discovered duplicated packet, skipping");
             return std::shared_ptr<Packet>();
         }
-
-        if (seqno > maxno)
-            maxno = seqno;
-        if (seqno < minno)
-            minno = seqno;
     }
 
-    // Get amount of available audio (in milliseconds) in jitter buffer
-    auto available = findTimelength();
+    // Minimal sequence number in buffer
+    uint32_t minno = mCount ? mFrontSeqno : 0xFFFFFFFF;
 
-    if (newSeqno > minno || (available < mHigh))
+    if (newSeqno > minno || (mTimelength < mHigh))
     {
-        // Insert into queue
-        auto p = std::make_shared<Packet>(packet, timelength, rate);
-        mPacketList.push_back(p);
-
-        // Sort again
-        std::sort(mPacketList.begin(), mPacketList.end(), SequenceSort);
+        // Packets too far from buffered ones do not fit the ring - older side gives way
+        if (mCount && newSeqno > mBackSeqno)
+        {
+            while (mCount && size_t(newSeqno - mFrontSeqno) >= RTP_BUFFER_RING_MAX_SIZE)
+                dropFront();
+        }
+        else
+        if (mCount && newSeqno < mFrontSeqno && size_t(mBackSeqno - newSeqno) >= RTP_BUFFER_RING_MAX_SIZE)
+        {
+            ICELogMedia(<< "Too old packet, skipping");
+            mStat.mOldRtp++;
+            return std::shared_ptr<Packet>();
+        }
 
-        // Limit by max timelength
-        available = findTimelength();
+        // Insert into ring; order is given by position
+        auto p = std::allocate_shared<Packet>(RtpMemoryPool::Allocator<Packet>(), packet, timelength, rate);
+        insert(p, newSeqno);
 
-        if (available > mHigh)
-            ICELogMedia(<< "Available " << available << " with limit " << mHigh);
+        if (mTimelength > mHigh)
+            ICELogMedia(<< "Available " << mTimelength << " with limit " << mHigh);
 
         return p;
     }
@@ -184,70 +239,117 @@ std::shared_ptr<RtpBuffer::Packet> RtpBuffer::add(const std::shared_ptr<jrtplib:
     return std::shared_ptr<Packet>();
 }
 
+void RtpBuffer::dropFront()
+{
+    ICELogMedia( << "Dropping RTP packets from jitter buffer");
+
+    // Before advancing mLastSeqno over the dropped packet, record a loss event for any
+    // sequence-number gap on the wire between the previous packet we saw and this one.
+    // Without this, drops silently mask real packet loss that happened between them.
+    auto droppingPacket = popFront();
+    uint32_t droppingSeq = droppingPacket->rtp()->GetExtendedSequenceNumber();
+    if (mLastSeqno)
+    {
+        int gap = (int64_t)droppingSeq - (int64_t)*mLastSeqno - 1;
+        if (gap > 0)
+        {
+            mStat.mPacketLoss += gap;
+            if (mStat.mPacketLossTimeline.empty() || (mStat.mPacketLossTimeline.back().mEndSeqno != droppingSeq))
+            {
+                auto gapStart = RtpHelper::toMicroseconds(*mLastReceiveTime);
+                auto gapEnd = RtpHelper::toMicroseconds(droppingPacket->rtp()->GetReceiveTime());
+                mStat.mPacketLossTimeline.emplace_back(PacketLossEvent{.mStartSeqno = *mLastSeqno,
+                                                                       .mEndSeqno = droppingSeq,
+                                                                       .mGap = gap,
+                                                                       .mTimestampStart = gapStart,
+                                                                       .mTimestampEnd = gapEnd});
+            }
+        }
+    }
+
+    // Save it as last packet however - to not confuse loss packet counter
+    mFetchedPacket = droppingPacket;
+    mLastSeqno = droppingSeq;
+    mLastReceiveTime = mFetchedPacket->rtp()->GetReceiveTime();
+
+    // Increase number in statistics
+    mStat.mPacketDropped++;
+}
+
 void RtpBuffer::trimToHighWater(size_t maxPackets)
 {
     Lock l(mGuard);
 
-    auto total = findTimelength();
-
     // Drop the oldest packet while either bound is exceeded: the time-based
     // high-water mark (mHigh, when set) or, if maxPackets != 0, the packet-count
     // cap. Always keep at least one packet so loss/gap accounting has a reference.
-    while (mPacketList.size() > 1 &&
-           ((0ms != mHigh && total > mHigh) ||
-            (maxPackets != 0 && mPacketList.size() > maxPackets)))
+    while (mCount > 1 &&
+           ((0ms != mHigh && mTimelength > mHigh) ||
+            (maxPackets != 0 && mCount > maxPackets)))
     {
-        ICELogMedia( << "Dropping RTP packets from jitter buffer");
-        total -= mPacketList.front()->timelength();
-
-        // Before advancing mLastSeqno over the dropped packet, record a loss event for any
-        // sequence-number gap on the wire between the previous packet we saw and this one.
-        // Without this, drops silently mask real packet loss that happened between them.
-        auto droppingPacket = mPacketList.front();
-        uint32_t droppingSeq = droppingPacket->rtp()->GetExtendedSequenceNumber();
-        if (mLastSeqno)
-        {
-            int gap = (int64_t)droppingSeq - (int64_t)*mLastSeqno - 1;
-            if (gap > 0)
-            {
-                mStat.mPacketLoss += gap;
-                if (mStat.mPacketLossTimeline.empty() || (mStat.mPacketLossTimeline.back().mEndSeqno != droppingSeq))
-                {
-                    auto gapStart = RtpHelper::toMicroseconds(*mLastReceiveTime);
-                    auto gapEnd = RtpHelper::toMicroseconds(droppingPacket->rtp()->GetReceiveTime());
-                    mStat.mPacketLossTimeline.emplace_back(PacketLossEvent{.mStartSeqno = *mLastSeqno,
-                                                                           .mEndSeqno = droppingSeq,
-                                                                           .mGap = gap,
-                                                                           .mTimestampStart = gapStart,
-                                                                           .mTimestampEnd = gapEnd});
-                }
-            }
-        }
+        dropFront();
+    }
+}
 
-        // Save it as last packet however - to not confuse loss packet counter
-        mFetchedPacket = droppingPacket;
-        mLastSeqno = droppingSeq;
-        mLastReceiveTime = mFetchedPacket->rtp()->GetReceiveTime();
+RtpBuffer::FetchResult RtpBuffer::fetch()
+{
+    Lock l(mGuard);
+    return fetchLocked();
+}
 
-        // Erase from packet list
-        mPacketList.erase(mPacketList.begin());
+size_t RtpBuffer::fetchWhile(const std::function<bool(const FetchResult&)>& handler)
+{
+    Lock l(mGuard);
+
+    size_t result = 0;
+    for (;;)
+    {
+        FetchResult fr = fetchLocked();
+        if (fr.mStatus == FetchResult::Status::NoPacket)
+            break;
 
-        // Increase number in statistics
-        mStat.mPacketDropped++;
+        result++;
+        if (!handler(fr))
+            break;
     }
+    return result;
 }
 
-RtpBuffer::FetchResult RtpBuffer::fetch()
+size_t RtpBuffer::fetchRun(ResultList& packets, const std::function<bool(const Packet&)>& accept)
 {
     Lock l(mGuard);
 
+    size_t result = 0;
+    for (;;)
+    {
+        // The same checks as fetchLocked() does - stop where it would return anything but next packet
+        trimToHighWater();
+        if (!mLastSeqno || !mCount || mTimelength < mLow || mTimelength == 0ms)
+            break;
+
+        auto& packet = slot(mFrontSeqno);
+        if (!packet || packet->rtp()->GetExtendedSequenceNumber() != *mLastSeqno + 1 || !accept(*packet))
+            break;
+
+        FetchResult fr = fetchLocked();
+        if (fr.mStatus != FetchResult::Status::RegularPacket)
+            break;
+
+        packets.push_back(fr.mPacket);
+        result++;
+    }
+    return result;
+}
+
+RtpBuffer::FetchResult RtpBuffer::fetchLocked()
+{
     FetchResult result;
 
     // Bound the buffer to the high-water mark before fetching.
     trimToHighWater();
 
     // See how much audio is buffered now.
-    auto total = findTimelength();
+    auto total = mTimelength;
 
     if (total < mLow || total == 0ms)
     {
@@ -258,7 +360,7 @@ RtpBuffer::FetchResult RtpBuffer::fetch()
     {
         if (mLastSeqno) // It means we had previous packet
         {
-            if (mPacketList.empty())
+            if (!mCount)
             {
                 // Don't increase counter of lost packets here; maybe it is DTX
                 result = {FetchResult::Status::NoPacket};
@@ -266,7 +368,7 @@ RtpBuffer::FetchResult RtpBuffer::fetch()
             else
             {
                 // Current sequence number ?
-                auto& packet = *mPacketList.front();
+                auto& packet = *slot(mFrontSeqno);
                 uint32_t seqno = packet.rtp()->GetExtendedSequenceNumber();
 
                 // Gap between new packet and previous on
@@ -292,37 +394,32 @@ RtpBuffer::FetchResult RtpBuffer::fetch()
                     // It is not big problem - as gap is detected when we have smth to return usually
                     mLastSeqno = seqno;
                     mLastReceiveTime = packet.rtp()->GetReceiveTime();
-                    result = {FetchResult::Status::Gap};
+                    result = {FetchResult::Status::Gap, slot(mFrontSeqno), gap};
                 }
                 else
                 {
-                    result = {FetchResult::Status::RegularPacket, mPacketList.front()};
+                    // Remove returned packet from the ring
+                    result = {FetchResult::Status::RegularPacket, popFront()};
 
                     // Save last returned normal packet
                     mFetchedPacket = result.mPacket;
                     mLastSeqno = result.mPacket->rtp()->GetExtendedSequenceNumber();
                     mLastReceiveTime = result.mPacket->rtp()->GetReceiveTime();
-
-                    // Remove returned packet from the list
-                    mPacketList.erase(mPacketList.begin());
                 }
             }
         }
         else
         {
             // See if prebuffer limit is reached
-            if (findTimelength() >= mPrebuffer && !mPacketList.empty())
+            if (mTimelength >= mPrebuffer && mCount)
             {
-                // Normal packet will be returned
-                result = {FetchResult::Status::RegularPacket, mPacketList.front()};
+                // Normal packet will be returned; remove it from buffer
+                result = {FetchResult::Status::RegularPacket, popFront()};
 
                 // Remember returned packet
                 mFetchedPacket = result.mPacket;
                 mLastSeqno = result.mPacket->rtp()->GetExtendedSequenceNumber();
                 mLastReceiveTime = result.mPacket->rtp()->GetReceiveTime();
-
-                // Remove returned packet from buffer list
-                mPacketList.erase(mPacketList.begin());
             }
             else
             {
@@ -340,10 +437,7 @@ RtpBuffer::FetchResult RtpBuffer::fetch()
 
 std::chrono::milliseconds RtpBuffer::findTimelength()
 {
-    std::chrono::milliseconds r = 0ms;
-    for (const auto& p: mPacketList)
-        r += p->timelength();
-    return r;
+    return mTimelength;
 }
 
 int RtpBuffer::getNumberOfReturnedPackets() const
@@ -356,6 +450,82 @@ int RtpBuffer::getNumberOfAddPackets() const
     return mAddCounter;
 }
 
+//-------------- PlayoutDelayEstimator ---------------
+void PlayoutDelayEstimator::process(uint32_t timestamp, int rate, double receiveTime, std::chrono::milliseconds packetTime)
+{
+    if (rate <= 0)
+        return;
+
+    // New clock rate means new media time base
+    if (rate != mRate)
+    {
+        reset();
+        mRate = rate;
+    }
+
+    if (!mBaseTimestamp)
+    {
+        mBaseTimestamp = timestamp;
+        mBaseTime = receiveTime;
+    }
+
+    // Signed difference survives RTP timestamp wrap
+    double mediaTime = double(int32_t(timestamp - *mBaseTimestamp)) * 1000.0 / rate;
+    double delay = receiveTime - mBaseTime - mediaTime;
+
+    // Timestamp jump (new source, restart) - start over
+    if (std::fabs(delay) > 10000.0)
+    {
+        reset();
+        mRate = rate;
+        mBaseTimestamp = timestamp;
+        mBaseTime = receiveTime;
+        delay = 0.0;
+    }
+
+    if (mDelays.size() < RTP_BUFFER_ADAPTIVE_WINDOW)
+        mDelays.push_back(static_cast<float>(delay));
+    else
+        mDelays[mNext] = static_cast<float>(delay);
+    mNext = (mNext + 1) % RTP_BUFFER_ADAPTIVE_WINDOW;
+
+    if (packetTime > 0ms)
+        mPacketTime = packetTime;
+
+    // Percentile is not needed per packet
+    if (++mSinceUpdate >= 8)
+        update();
+}
+
+void PlayoutDelayEstimator::update()
+{
+    mSinceUpdate = 0;
+    if (mDelays.size() < 16)
+        return;
+
+    mScratch = mDelays;
+    auto minimum = *std::min_element(mScratch.begin(), mScratch.end());
+    auto percentile = mScratch.begin() + (mScratch.size() * 95) / 100;
+    std::nth_element(mScratch.begin(), percentile, mScratch.end());
+
+    auto target = std::chrono::milliseconds(lround(*percentile - minimum)) + mPacketTime;
+    mTarget = std::min(target, std::chrono::milliseconds(RTP_BUFFER_ADAPTIVE_MAX));
+}
+
+std::chrono::milliseconds PlayoutDelayEstimator::target() const
+{
+    return mTarget;
+}
+
+void PlayoutDelayEstimator::reset()
+{
+    mDelays.clear();
+    mNext = 0;
+    mSinceUpdate = 0;
+    mBaseTimestamp.reset();
+    mRate = 0;
+}
+
 //-------------- Receiver ---------------
 Receiver::Receiver(Statistics& stat)
     :mStat(stat)
@@ -366,11 +536,10 @@ Receiver::~Receiver()
 
 //-------------- AudioReceiver ----------------
 AudioReceiver::AudioReceiver(const CodecList::Settings& settings, MT::Statistics &stat)
-    :Receiver(stat), mRtpBuffer(stat), mDtmfBuffer(stat), mCodecSettings(settings), mCodecList(settings), mDtmfReceiver(stat)
+    :Receiver(stat), mRtpBuffer(stat), mDtmfBuffer(stat), mCodecSettings(settings), mDtmfReceiver(stat)
 {
-    // Init codecs
-    mCodecList.setSettings(settings);
-    mCodecList.fillCodecMap(mCodecMap);
+    // Codecs are created on first packet of given payload type
+    mCodecRegistry = CodecRegistry::get(settings);
 
     mDtmfBuffer.setPrebuffer(0ms);
     mDtmfBuffer.setLow(0ms);
@@ -412,10 +581,22 @@ void AudioReceiver::setCodecSettings(const CodecList::Settings& codecSettings)
         return;
 
     mCodecSettings = codecSettings;
-    mCodecList.setSettings(mCodecSettings); // This builds factory list with proper payload types according to payload types in settings
+    mCodecRegistry = CodecRegistry::get(mCodecSettings);
 
-    // Rebuild codec map from factory list
-    mCodecList.fillCodecMap(mCodecMap);
+    // Codecs will be created again from new factories
+    mCodecMap.clear();
+}
+
+PCodec AudioReceiver::codecFor(int payloadType)
+{
+    auto codecIter = mCodecMap.find(payloadType);
+    if (codecIter != mCodecMap.end())
+        return codecIter->second;
+
+    PCodec result = mCodecRegistry->create(payloadType);
+    if (result)
+        mCodecMap.insert({payloadType, result});
+    return result;
 }
 
 CodecList::Settings& AudioReceiver::getCodecSettings()
@@ -446,17 +627,10 @@ Codec* AudioReceiver::add(const std::shared_ptr<jrtplib::RTPPacket>& p)
     }
     else
     {
-        // Look for codec
-        // Check if codec can be handled
-        auto codecIter = mCodecMap.find(ptype);
-        if (codecIter != mCodecMap.end())
+        // Look for codec; it is created on the first packet with this payload type
+        codec = codecFor(ptype).get();
+        if (codec)
         {
-            // Check if codec is creating lazily
-            if (!codecIter->second)
-            {
-                codecIter->second = mCodecList.createCodecByPayloadType(ptype);
-            }
-            codec = codecIter->second.get();
 
             // Return pointer to codec if needed.get()
             if (mStat.mCodecName.empty() && codec)
@@ -479,6 +653,9 @@ Codec* AudioReceiver::add(const std::shared_ptr<jrtplib::RTPPacket>& p)
         mJitterStats.process(p.get(), samplerate);
         mStat.mJitter = static_cast<float>(mJitterStats.get());
 
+        if (mCodecSettings.mAdaptivePlayout)
+            mDelayEstimator.process(p->GetTimestamp(), samplerate, p->GetReceiveTime().GetDouble() * 1000.0, std::chrono::milliseconds(time_length));
+
         if (!codec)
             return nullptr;
 
@@ -501,7 +678,7 @@ Codec* AudioReceiver::add(const std::shared_ptr<jrtplib::RTPPacket>& p)
     return codec;
 }
 
-void AudioReceiver::processDecoded(Audio::DataWindow& output, DecodeOptions options)
+void AudioReceiver::processDecoded(Output& output, DecodeOptions options)
 {
     // Write to audio dump if requested
     if (mDecodedDump && mDecodedLength)
@@ -514,7 +691,7 @@ void AudioReceiver::processDecoded(Audio::DataWindow& output, DecodeOptions opti
     output.add(mResampledFrame.data(), mResampledLength);
 }
 
-void AudioReceiver::produceSilence(std::chrono::milliseconds length, Audio::DataWindow& output, DecodeOptions options)
+void AudioReceiver::produceSilence(std::chrono::milliseconds length, Output& output, DecodeOptions options)
 {
     if (!mCodec)
         return;
@@ -540,7 +717,7 @@ void AudioReceiver::produceSilence(std::chrono::milliseconds length, Audio::Data
     }
 }
 
-void AudioReceiver::produceCNG(std::chrono::milliseconds length, Audio::DataWindow& output, DecodeOptions options)
+void AudioReceiver::produceCNG(std::chrono::milliseconds length, Output& output, DecodeOptions options)
 {
     int frames100ms = length.count() / 100;
     for (int frameIndex = 0; frameIndex < frames100ms; frameIndex++)
@@ -568,7 +745,54 @@ void AudioReceiver::produceCNG(std::chrono::milliseconds length, Audio::DataWind
     }
 }
 
-AudioReceiver::DecodeResult AudioReceiver::decodeGapTo(Audio::DataWindow& output, DecodeOptions options)
+void AudioReceiver::adaptPlayout(size_t offset, DecodeOptions options)
+{
+    if (!mCodec)
+        return;
+
+    Audio::Format fmt = options.mResampleToMainRate ? Audio::Format(AUDIO_SAMPLERATE, 1) : mCodec->getAudioFormat();
+    if (fmt.channels() != 1 || mAvailable.filled() <= offset)
+        return;
+
+    auto target = mDelayEstimator.target();
+    mStat.mPlayoutDelay.process(static_cast<float>(target.count()));
+
+    // Packets are dropped only if time-stretching can not keep up
+    mRtpBuffer.setHigh(std::max(std::chrono::milliseconds(RTP_BUFFER_ADAPTIVE_HIGH), target * 2));
+
+    // Audio waiting for playout: undecoded packets + decoded but not played yet
+    auto level = mRtpBuffer.findTimelength() + mAvailable.getTimeLength(fmt);
+    auto threshold = std::max(std::chrono::milliseconds(mLastPacketTimeLength), 10ms);
+
+    int16_t* samples = reinterpret_cast<int16_t*>(mAvailable.mutableData() + offset);
+    size_t count = (mAvailable.filled() - offset) / sizeof(int16_t);
+    size_t result = count;
+
+    if (level > target + threshold)
+    {
+        result = mTimeStretch.accelerate(samples, count, fmt.rate());
+        if (result < count)
+        {
+            mStat.mAccelerateCount++;
+            mStat.mAcceleratedTime += std::chrono::milliseconds((count - result) * 1000 / fmt.rate());
+        }
+    }
+    else
+    if (level < target)
+    {
+        result = mTimeStretch.expand(samples, count, (mAvailable.capacity() - offset) / sizeof(int16_t), fmt.rate());
+        if (result > count)
+        {
+            mStat.mExpandCount++;
+            mStat.mExpandedTime += std::chrono::milliseconds((result - count) * 1000 / fmt.rate());
+        }
+    }
+
+    if (result != count)
+        mAvailable.setFilled(offset + result * sizeof(int16_t));
+}
+
+AudioReceiver::DecodeResult AudioReceiver::decodeGapTo(Output& output, DecodeOptions options, const RtpBuffer::FetchResult& gap)
 {
     ICELogMedia(<< "Gap detected.");
 
@@ -592,6 +816,37 @@ AudioReceiver::DecodeResult AudioReceiver::decodeGapTo(Audio::DataWindow& output
             mDecodedLength = 0;
         else
         {
+            // Packet after the gap may carry in-band FEC copy of the lost one (Opus LBRR) - it is better than PLC.
+            // The copy describes only the packet right before 'next'; earlier packets of longer gap are concealed first.
+            std::shared_ptr<jrtplib::RTPPacket> next = gap.mPacket ? gap.mPacket->rtp() : nullptr;
+            if (next)
+            {
+                auto codecIter = mCodecMap.find(next->GetPayloadType());
+                std::span<const uint8_t> payload = {(const uint8_t*)next->GetPayloadData(), next->GetPayloadLength()};
+                if (codecIter != mCodecMap.end() && codecIter->second == mCodec && mCodec->hasFec(payload))
+                {
+                    std::span<uint8_t> buffer = {(uint8_t*)mDecodedFrame.data(), mDecodedFrame.size() * sizeof(int16_t)};
+                    size_t concealed = 0;
+                    if (gap.mLost > 1)
+                    {
+                        // Room for recovered packet is kept; overlong gap is concealed partially
+                        size_t reserve = std::min(buffer.size(), (size_t)mCodec->pcmLength());
+                        concealed = mCodec->plc((gap.mLost - 1) * std::max(mFrameCount, 1), buffer.first(buffer.size() - reserve));
+                    }
+
+                    size_t recovered = mCodec->decodeFec(payload, buffer.subspan(concealed));
+                    if (recovered)
+                        mStat.mFecRecovered++;
+
+                    mDecodedLength = concealed + recovered;
+                    if (mDecodedLength)
+                    {
+                        processDecoded(output, options);
+                        return {.mStatus = DecodeResult::Status::Ok, .mSamplerate = mCodec->samplerate(), .mChannels = mCodec->channels()};
+                    }
+                }
+            }
+
             mDecodedLength = mCodec->plc(mFrameCount, {(uint8_t*)mDecodedFrame.data(), mDecodedFrame.size() * sizeof(int16_t)});
             if (!mDecodedLength)
             {
@@ -613,7 +868,14 @@ AudioReceiver::DecodeResult AudioReceiver::decodeGapTo(Audio::DataWindow& output
         return {.mStatus = DecodeResult::Status::Skip};
 }
 
-AudioReceiver::DecodeResult AudioReceiver::decodePacketTo(Audio::DataWindow& output, DecodeOptions options, const std::shared_ptr<RtpBuffer::Packet>& packet)
+// RFC 3389 comfort noise or too short G.711 payload treated the same way
+static bool isCngPacket(const jrtplib::RTPPacket& rtp)
+{
+    int ptype = rtp.GetPayloadType();
+    return ((ptype == 0 || ptype == 8) && rtp.GetPayloadLength() >= 1 && rtp.GetPayloadLength() <= 6) || ptype == 13;
+}
+
+AudioReceiver::DecodeResult AudioReceiver::decodePacketTo(Output& output, DecodeOptions options, const std::shared_ptr<RtpBuffer::Packet>& packet)
 {
     if (!packet || !packet->rtp())
         return {DecodeResult::Status::Skip};
@@ -645,22 +907,19 @@ AudioReceiver::DecodeResult AudioReceiver::decodePacketTo(Audio::DataWindow& out
     // Find codec by payload type
     int ptype = rtp.GetPayloadType();
 
-    // Look into mCodecMap if exists
-    auto codecIter = mCodecMap.find(ptype);
-    if (codecIter == mCodecMap.end())
+    // Codec is created here if add() did not see this payload type yet
+    PCodec codec = codecFor(ptype);
+    if (!codec)
         return  {};
 
-    if (!codecIter->second)
-        codecIter->second = mCodecList.createCodecByPayloadType(ptype);
-
-    mCodec = codecIter->second;
+    mCodec = codec;
     if (mCodec)
     {
         result.mChannels = mCodec->channels();
         result.mSamplerate = mCodec->samplerate();
 
         // Check if it is CNG packet
-        if (((ptype == 0 || ptype == 8) && rtp.GetPayloadLength() >= 1 && rtp.GetPayloadLength() <= 6) || rtp.GetPayloadType() == 13)
+        if (isCngPacket(rtp))
         {
             if (options.mSkipDecode)
                 mDecodedLength = 0;
@@ -733,6 +992,126 @@ AudioReceiver::DecodeResult AudioReceiver::decodePacketTo(Audio::DataWindow& out
     return result;
 }
 
+bool AudioReceiver::continuesBatch(const RtpBuffer::Packet& packet)
+{
+    if (!mCodec || mCodecSettings.mSkipDecode || mBatch.size() >= MT_MAX_DECODEBATCH)
+        return false;
+
+    // Previous packet is the last queued one or the last decoded
+    uint32_t previousTimestamp = 0;
+    int previousTimeLength = 0;
+    if (!mBatch.empty())
+    {
+        const auto& previous = *mBatch.back()->rtp();
+        previousTimestamp = previous.GetTimestamp();
+        previousTimeLength = (mCodec->rtpLength() ? (int)previous.GetPayloadLength() / mCodec->rtpLength() : 1) * mCodec->frameTime();
+    }
+    else
+    if (mLastPacketTimestamp && mLastPacketTimeLength)
+    {
+        previousTimestamp = *mLastPacketTimestamp;
+        previousTimeLength = mLastPacketTimeLength;
+    }
+    else
+        return false;
+
+    const auto& rtp = *packet.rtp();
+    if (isCngPacket(rtp) || codecFor(rtp.GetPayloadType()) != mCodec)
+        return false;
+
+    size_t payload_length = rtp.GetPayloadLength();
+    if (!payload_length || (mCodec->rtpLength() && payload_length % mCodec->rtpLength()))
+        return false;
+
+    // Timestamp jump means DTX - silence is emitted by decodePacketTo()
+    int units = rtp.GetTimestamp() - previousTimestamp;
+    return units / (mCodec->samplerate() / 1000) <= previousTimeLength;
+}
+
+size_t AudioReceiver::batchCapacity()
+{
+    // Resampler skips the whole block if it does not fit mResampledFrame; keep few samples for rounding
+    uint64_t resampled = mResampledFrame.size() * sizeof(int16_t) - 16;
+    uint64_t rate = std::max(AUDIO_SAMPLERATE, mCodec->samplerate());
+    uint64_t result = resampled * mCodec->samplerate() * mCodec->channels() / (rate * AUDIO_CHANNELS);
+    result = std::min<uint64_t>(result, mDecodedFrame.size() * sizeof(int16_t));
+
+    // Whole samples of all channels
+    return result - result % (sizeof(int16_t) * mCodec->channels());
+}
+
+AudioReceiver::DecodeResult AudioReceiver::decodeBatchTo(Output& output, DecodeOptions options)
+{
+    if (mBatch.empty() || !mCodec)
+    {
+        mBatch.clear();
+        return {.mStatus = DecodeResult::Status::Skip};
+    }
+
+    // Split packets to codec frames
+    size_t rtp_frame_length = mCodec->rtpLength();
+    mBatchInputs.clear();
+    mBatchOwners.clear();
+    for (size_t p = 0; p < mBatch.size(); p++)
+    {
+        const auto& rtp = *mBatch[p]->rtp();
+        size_t frameLength = rtp_frame_length ? rtp_frame_length : rtp.GetPayloadLength();
+        for (size_t offset = 0; offset < rtp.GetPayloadLength(); offset += frameLength)
+        {
+            mBatchInputs.emplace_back(rtp.GetPayloadData() + offset, frameLength);
+            mBatchOwners.push_back(p);
+        }
+    }
+    mBatchResults.assign(mBatchInputs.size(), {});
+
+    // Decode as much frames as scratch buffers can take, then resample and send them at once
+    auto codecOutput = std::span{(uint8_t*)mDecodedFrame.data(), batchCapacity()};
+    for (size_t done = 0; done < mBatchInputs.size();)
+    {
+        size_t decoded = mCodec->decodeBatch(std::span{mBatchInputs}.subspan(done), codecOutput, std::span{mBatchResults}.subspan(done));
+        if (!decoded)
+        {
+            // Frame does not fit batch capacity - decode the rest one by one as decodePacketTo() does,
+            // so state set below matches what was really decoded
+            ICELogDebug(<< "Batch decode stopped, " << mBatchInputs.size() - done << " frames are decoded one by one");
+            auto frameOutput = std::span{(uint8_t*)mDecodedFrame.data(), mDecodedFrame.size() * sizeof(int16_t)};
+            for (; done < mBatchInputs.size(); done++)
+            {
+                mBatchResults[done] = mCodec->decode(mBatchInputs[done], frameOutput);
+                mDecodedLength = mBatchResults[done].mDecoded;
+                if (mDecodedLength > 0)
+                    processDecoded(output, options);
+            }
+            break;
+        }
+
+        mDecodedLength = 0;
+        for (size_t i = done; i < done + decoded; i++)
+            mDecodedLength += mBatchResults[i].mDecoded;
+        if (mDecodedLength > 0)
+            processDecoded(output, options);
+        done += decoded;
+    }
+
+    // The same state as decodePacketTo() leaves after the last packet
+    const auto& last = *mBatch.back()->rtp();
+    mFailedCount = 0;
+    mLastPacketTimestamp = last.GetTimestamp();
+    mFrameCount = rtp_frame_length ? last.GetPayloadLength() / rtp_frame_length : 1;
+    mLastPacketTimeLength = mFrameCount * mCodec->frameTime();
+
+    // Codec may mark frame as CNG (AMR SID); only the last packet matters as every regular packet resets it
+    mCngPacket.reset();
+    for (size_t i = 0; i < mBatchInputs.size(); i++)
+        if (mBatchOwners[i] == mBatch.size() - 1 && mBatchResults[i].mIsCng)
+            mCngPacket = mBatch.back();
+
+    updateAmrCodecStats(mCodec.get());
+    mBatch.clear();
+
+    return {.mStatus = DecodeResult::Status::Ok, .mSamplerate = mCodec->samplerate(), .mChannels = mCodec->channels()};
+}
+
 AudioReceiver::DecodeResult AudioReceiver::decodeEmptyTo(Audio::DataWindow& output, DecodeOptions options)
 {
     // There are two cases
@@ -766,7 +1145,8 @@ AudioReceiver::DecodeResult AudioReceiver::decodeEmptyTo(Audio::DataWindow& outp
             {
                 // Here we have another packet marked as CNG - for another decoder
                 // Just decode it +1 time
-                return decodePacketTo(output, options, mCngPacket);
+                WindowOutput windowOutput(output);
+                return decodePacketTo(windowOutput, options, mCngPacket);
             }
         }
         else
@@ -824,6 +1204,7 @@ AudioReceiver::DecodeResult AudioReceiver::getAudioTo(Audio::DataWindow& output,
     // How much time length audio we produced here
     auto produced = 0ms;
     Audio::Format fmt;
+    WindowOutput available(mAvailable);
 
     // Have we anything from the previous decode attempts ?
     if (mAvailable.filled())
@@ -854,9 +1235,35 @@ AudioReceiver::DecodeResult AudioReceiver::getAudioTo(Audio::DataWindow& output,
         // Decode to mAvailable buffer
         switch (fr.mStatus)
         {
-        case RtpBuffer::FetchResult::Status::Gap:           result = decodeGapTo(mAvailable, options.decreaseElapsedBy(produced));                                                      break;
+        case RtpBuffer::FetchResult::Status::Gap:           result = decodeGapTo(available, options.decreaseElapsedBy(produced), fr);                                                    break;
         case RtpBuffer::FetchResult::Status::NoPacket:      result = decodeEmptyTo(mAvailable, options.decreaseElapsedBy(produced));                                                    break;
-        case RtpBuffer::FetchResult::Status::RegularPacket: result = decodePacketTo(mAvailable, options.decreaseElapsedBy(produced), fr.mPacket);   updateDecodeIntervalStatistics();   break;
+        case RtpBuffer::FetchResult::Status::RegularPacket:
+            {
+                size_t offset = mAvailable.filled();
+                DecodeOptions step = options.decreaseElapsedBy(produced);
+                bool adaptive = options.mRealtimeProcessing && mCodecSettings.mAdaptivePlayout;
+
+                // Catch-up: request is longer than this packet - decode following ready packets with it at once
+                if (!adaptive && !options.mSkipDecode && step.mElapsed > fr.mPacket->timelength() && continuesBatch(*fr.mPacket))
+                {
+                    auto length = fr.mPacket->timelength();
+                    mBatch.push_back(fr.mPacket);
+                    mRtpBuffer.fetchRun(mBatch, [&](const RtpBuffer::Packet& p)
+                    {
+                        if (length >= step.mElapsed || !continuesBatch(p))
+                            return false;
+                        length += p.timelength();
+                        return true;
+                    });
+                    result = decodeBatchTo(available, step);
+                }
+                else
+                    result = decodePacketTo(available, step, fr.mPacket);
+                updateDecodeIntervalStatistics();
+                if (options.mRealtimeProcessing && mCodecSettings.mAdaptivePlayout && !options.mSkipDecode)
+                    adaptPlayout(offset, options);
+            }
+            break;
         default:
             assert(0);
         }
@@ -891,6 +1298,189 @@ AudioReceiver::DecodeResult AudioReceiver::getAudioTo(Audio::DataWindow& output,
     return result;
 }
 
+AudioReceiver::BulkResult AudioReceiver::decodeAll(Output& output, DecodeOptions options)
+{
+    ensureDecodeBuffers();
+
+    // RFC2833 events are reported via callbacks only
+    for (int i = mDtmfBuffer.getCount(); i > 0; i--)
+        processDtmf();
+
+    BulkResult result;
+
+    // Forwards decoded audio to caller's output until time limit; the rest is kept in mAvailable
+    class LimitedOutput: public Output
+    {
+    public:
+        LimitedOutput(AudioReceiver& receiver, Output& output, DecodeOptions options)
+            :mReceiver(receiver), mOutput(output), mOptions(options)
+        {
+            updateFormat();
+        }
+
+        void add(const void* data, size_t bytes) override
+        {
+            size_t accepted = std::min(bytes, space());
+            if (accepted)
+                mOutput.add(data, accepted);
+            if (accepted < bytes)
+                mReceiver.mAvailable.add(reinterpret_cast<const uint8_t*>(data) + accepted, bytes - accepted);
+            mBytes += accepted;
+        }
+
+        bool full() const override
+        {
+            return mOutput.full() || (mOptions.mElapsed != 0ms && mBytes >= mLimitBytes);
+        }
+
+        size_t space() const override
+        {
+            return mOptions.mElapsed != 0ms ? (mLimitBytes > mBytes ? mLimitBytes - mBytes : 0) : SIZE_MAX;
+        }
+
+        // Moves audio left by previous call to output, up to limit and output's space
+        void addAvailable()
+        {
+            Audio::DataWindow& available = mReceiver.mAvailable;
+            size_t bytes = std::min({(size_t)available.filled(), space(), mOutput.space()});
+            if (!bytes)
+                return;
+            mOutput.add(available.data(), bytes);
+            available.erase(bytes);
+            mBytes += bytes;
+        }
+
+        // Output format changes only when the first packet selects codec or payload type is switched
+        const Audio::Format& format()
+        {
+            if (mReceiver.mCodec.get() != mFormatCodec)
+                updateFormat();
+            return mFormat;
+        }
+
+        size_t bytes() const
+        {
+            return mBytes;
+        }
+
+    protected:
+        AudioReceiver& mReceiver;
+        Output& mOutput;
+        DecodeOptions mOptions;
+        Audio::Format mFormat;
+        Codec* mFormatCodec = nullptr;
+        size_t mLimitBytes = 0;
+        size_t mBytes = 0;
+
+        void updateFormat()
+        {
+            mFormatCodec = mReceiver.mCodec.get();
+            mFormat = mOptions.mResampleToMainRate || !mFormatCodec ? Audio::Format(AUDIO_SAMPLERATE, 1) : mFormatCodec->getAudioFormat();
+            mLimitBytes = mFormat.sizeFromTime(mOptions.mElapsed);
+        }
+    };
+
+    LimitedOutput limited(*this, output, options);
+
+    // Audio left by previous call goes first
+    limited.addAvailable();
+
+    if (!limited.full())
+    {
+        // Packets continuing each other are queued and decoded at once
+        auto batchLength = 0ms;
+        auto flush = [&](DecodeOptions step)
+        {
+            if (!mBatch.empty())
+                decodeBatchTo(limited, step);
+            batchLength = 0ms;
+        };
+
+        DecodeOptions step = options;
+        result.mPackets = mRtpBuffer.fetchWhile([&](const RtpBuffer::FetchResult& fr)
+        {
+            // Without time limit DTX silence before a packet is limited to 10 seconds - the same as realtime decode may produce
+            step = options;
+            step.mElapsed = options.mElapsed != 0ms ? options.mElapsed - std::chrono::milliseconds(lround(limited.format().timeFromSize(limited.bytes()))) : 10000ms;
+
+            if (fr.mStatus == RtpBuffer::FetchResult::Status::RegularPacket && !options.mSkipDecode && continuesBatch(*fr.mPacket))
+            {
+                mBatch.push_back(fr.mPacket);
+                batchLength += fr.mPacket->timelength();
+                if (batchLength >= step.mElapsed || mBatch.size() >= MT_MAX_DECODEBATCH)
+                    flush(step);
+                return !limited.full();
+            }
+            flush(step);
+
+            DecodeResult r;
+            if (fr.mStatus == RtpBuffer::FetchResult::Status::Gap)
+                r = decodeGapTo(limited, step, fr);
+            else
+                r = decodePacketTo(limited, step, fr.mPacket);
+
+            if (r.mStatus == DecodeResult::Status::BadPacket && result.mStatus == DecodeResult::Status::Skip)
+                result.mStatus = DecodeResult::Status::BadPacket;
+
+            return !limited.full();
+        });
+        flush(step);
+    }
+
+    result.mBytes = limited.bytes();
+    result.mTruncated = output.full();
+    if (mCodec)
+    {
+        const Audio::Format& fmt = limited.format();
+        result.mSamplerate = fmt.rate();
+        result.mChannels = fmt.channels();
+        mProducedAudio += std::chrono::milliseconds(lround(fmt.timeFromSize(result.mBytes)));
+    }
+    if (result.mBytes)
+        result.mStatus = DecodeResult::Status::Ok;
+
+    return result;
+}
+
+AudioReceiver::BulkResult AudioReceiver::decodeAll(std::span<int16_t> output, DecodeOptions options)
+{
+    // Writes to caller's span; what does not fit stays in mAvailable
+    class SpanOutput: public Output
+    {
+    public:
+        SpanOutput(AudioReceiver& receiver, std::span<int16_t> output)
+            :mReceiver(receiver), mOutput(std::as_writable_bytes(output))
+        {}
+
+        void add(const void* data, size_t bytes) override
+        {
+            size_t accepted = std::min(bytes, mOutput.size() - mFilled);
+            memcpy(mOutput.data() + mFilled, data, accepted);
+            mFilled += accepted;
+            if (accepted < bytes)
+                mReceiver.mAvailable.add(reinterpret_cast<const uint8_t*>(data) + accepted, bytes - accepted);
+        }
+
+        bool full() const override
+        {
+            return mFilled == mOutput.size();
+        }
+
+        size_t space() const override
+        {
+            return mOutput.size() - mFilled;
+        }
+
+    protected:
+        AudioReceiver& mReceiver;
+        std::span<std::byte> mOutput;
+        size_t mFilled = 0;
+    };
+
+    SpanOutput spanOutput(*this, output);
+    return decodeAll(spanOutput, options);
+}
+
 void AudioReceiver::ensureDecodeBuffers()
 {
     // Allocate the decode/convert/resample scratch buffers to full capacity on the
@@ -901,6 +1491,7 @@ void AudioReceiver::ensureDecodeBuffers()
         mDecodedFrame.resize(MT_MAX_DECODEBUFFER);
         mConvertedFrame.resize(MT_MAX_DECODEBUFFER * 2);
         mResampledFrame.resize(MT_MAX_DECODEBUFFER);
+        mBatch.reserve(MT_MAX_DECODEBATCH);
     }
 
     if (!mAvailable.capacity())
@@ -946,11 +1537,7 @@ void AudioReceiver::makeMonoAndResample(int rate, int channels)
 
 Codec* AudioReceiver::findCodec(int payloadType)
 {
-    MT::CodecMap::const_iterator codecIter = mCodecMap.find(payloadType);
-    if (codecIter == mCodecMap.end())
-        return nullptr;
-
-    return codecIter->second.get();
+    return codecFor(payloadType).get();
 }
 
 
@@ -987,10 +1574,7 @@ int AudioReceiver::getSize() const
 
 AudioReceiver::MediaInfo AudioReceiver::infoFor(jrtplib::RTPPacket& p)
 {
-    CodecMap::iterator codecIter = mCodecMap.find(p.GetPayloadType());
-    if (codecIter == mCodecMap.end())
-        return {};
-    PCodec codec = codecIter->second;
+    PCodec codec = codecFor(p.GetPayloadType());
     if (!codec)
         return {};
 
@@ -17,11 +17,14 @@
 #include "jrtplib/src/rtpsourcedata.h"
 #include "../audio/Audio_DataWindow.h"
 #include "../audio/Audio_Resampler.h"
+#include "../audio/Audio_TimeStretch.h"
 
 #include <optional>
 #include <chrono>
 #include <vector>
 #include <cstdint>
+#include <functional>
+#include <span>
 using namespace std::chrono_literals;
 
 namespace MT
@@ -64,7 +67,8 @@ public:
         };
 
         Status mStatus = Status::NoPacket;
-        std::shared_ptr<Packet> mPacket;
+        std::shared_ptr<Packet> mPacket;            // For Gap: packet following the gap; it stays in buffer
+        int mLost = 0;                              // For Gap: number of lost packets
 
         std::string toString() const
         {
@@ -95,6 +99,7 @@ public:
     int getNumberOfReturnedPackets() const;
     int getNumberOfAddPackets() const;
 
+    // Total duration of buffered packets; maintained on add/remove
     std::chrono::milliseconds findTimelength();
     int getCount() const;
 
@@ -106,6 +111,14 @@ public:
 
     FetchResult fetch();
 
+    // Fetches packets under single lock while buffer has something to return and handler returns true.
+    // Used by offline decode; returns number of fetched results.
+    size_t fetchWhile(const std::function<bool(const FetchResult&)>& handler);
+
+    // Fetches regular packets following the last returned one while accept() takes them; appends them to packets.
+    // Gap, rejected packet and prebuffering stay for fetch(). Used to decode several packets at once.
+    size_t fetchRun(ResultList& packets, const std::function<bool(const Packet&)>& accept);
+
     // Drop oldest packets so buffered audio stays within the high-water mark,
     // recording packet-loss events for any sequence gaps crossed (the same
     // accounting fetch() performs). Used to bound memory on streams that never
@@ -127,8 +140,26 @@ protected:
                 mAddCounter = 0;
 
     mutable Mutex mGuard;
-    typedef std::vector<std::shared_ptr<Packet>> PacketList;
-    PacketList mPacketList;
+
+    FetchResult fetchLocked();
+
+    // Ring of packets indexed by extended sequence number (slot = seqno & (size - 1)).
+    // Buffered packets occupy [mFrontSeqno..mBackSeqno]; missing packets leave empty slots.
+    typedef std::vector<std::shared_ptr<Packet>> PacketRing;
+    PacketRing mRing;
+    uint32_t mFrontSeqno = 0,
+             mBackSeqno = 0;
+    size_t   mCount = 0;
+    std::chrono::milliseconds mTimelength = 0ms;
+
+    std::shared_ptr<Packet>& slot(uint32_t seqno);
+    void insert(const std::shared_ptr<Packet>& p, uint32_t seqno);
+    void resize(size_t capacity);
+    std::shared_ptr<Packet> popFront();
+
+    // Drops oldest packet with loss accounting for sequence gap before it
+    void dropFront();
+
     Statistics& mStat;
     bool mFirstPacketWillGo = true;
     jrtplib::RTPSourceStats mRtpStats;
@@ -138,7 +169,32 @@ protected:
 
 
     // To calculate average interval between packet add. It is close to jitter but more useful in debugging.
-    float mLastAddTime = 0.0f;
+    double mLastAddTime = 0.0;         // Receive time of last added packet, milliseconds
+};
+
+// Estimates playout delay needed to absorb network jitter. Every packet gives relative delay -
+// receive time minus media time; target is spread between the fastest and 95th percentile packet
+// over last RTP_BUFFER_ADAPTIVE_WINDOW packets plus one packet duration.
+class PlayoutDelayEstimator
+{
+public:
+    // receiveTime is in milliseconds
+    void process(uint32_t timestamp, int rate, double receiveTime, std::chrono::milliseconds packetTime);
+    std::chrono::milliseconds target() const;
+    void reset();
+
+protected:
+    std::vector<float> mDelays;             // Ring of relative delays, milliseconds
+    std::vector<float> mScratch;
+    size_t      mNext = 0;
+    unsigned    mSinceUpdate = 0;
+    std::optional<uint32_t> mBaseTimestamp;
+    double      mBaseTime = 0.0;
+    int         mRate = 0;
+    std::chrono::milliseconds mTarget = std::chrono::milliseconds(RTP_BUFFER_PREBUFFER);
+    std::chrono::milliseconds mPacketTime = 20ms;
+
+    void update();
 };
 
 class Receiver
@@ -218,6 +274,36 @@ public:
 
     DecodeResult getAudioTo(Audio::DataWindow& output, DecodeOptions options);
 
+    // Destination of decoded audio for decodeAll()
+    class Output
+    {
+    public:
+        virtual ~Output() {}
+        virtual void add(const void* data, size_t bytes) = 0;
+
+        // decodeAll() stops fetching packets when output is full
+        virtual bool full() const { return false; }
+
+        // Bytes output takes without keeping the rest in receiver; audio left by previous call is moved within it
+        virtual size_t space() const { return SIZE_MAX; }
+    };
+
+    struct BulkResult
+    {
+        DecodeResult::Status mStatus = DecodeResult::Status::Skip;
+        int             mSamplerate = 0;
+        int             mChannels = 0;
+        size_t          mBytes = 0;             // Written to output
+        size_t          mPackets = 0;           // Fetched from jitter buffer, gaps included
+        bool            mTruncated = false;     // Output span is full; the rest stays in receiver for the next call
+    };
+
+    // Offline decode: drains jitter buffer in one pass writing straight to output, without per-call
+    // intermediate windows and locking. Gap / CNG / PLC / DTX handling is the same as in getAudioTo().
+    // options.mElapsed limits decoded time length (audio beyond it is kept for the next call); zero means whole buffer.
+    BulkResult decodeAll(Output& output, DecodeOptions options);
+    BulkResult decodeAll(std::span<int16_t> output, DecodeOptions options);
+
     // Looks for codec by payload type
     Codec*      findCodec(int payloadType);
     RtpBuffer&  getRtpBuffer() { return mRtpBuffer; }
@@ -241,12 +327,14 @@ protected:
     RtpBuffer                           mDtmfBuffer;            // These two (mDtmfBuffer / mDtmfReceiver) are for our analyzer stack only; in normal softphone logic DTMF packets goes via SingleAudioStream::mDtmfReceiver
     DtmfReceiver                        mDtmfReceiver;
 
-    CodecMap                            mCodecMap;
+    std::shared_ptr<const CodecRegistry> mCodecRegistry;
+    CodecMap                            mCodecMap;              // Codecs created so far, by payload type
     PCodec                              mCodec;
     int                                 mFrameCount = 0;
     CodecList::Settings                 mCodecSettings;
-    CodecList                           mCodecList;
     JitterStatistics                    mJitterStats;
+    PlayoutDelayEstimator               mDelayEstimator;
+    Audio::TimeStretch                  mTimeStretch;
     std::shared_ptr<RtpBuffer::Packet>  mCngPacket;
     CngDecoder                          mCngDecoder;
     size_t                              mDTXSamplesToEmit = 0;   // How much silence (or CNG) should be emited before next RTP packet gets into the action
@@ -302,17 +390,55 @@ protected:
     void makeMonoAndResample(int rate, int channels);
 
     // Resamples, sends to analysis, writes to dump and queues to output decoded frames from mDecodedFrame
-    void processDecoded(Audio::DataWindow& output, DecodeOptions options);
-    void produceSilence(std::chrono::milliseconds length, Audio::DataWindow& output, DecodeOptions options);
-    void produceCNG(std::chrono::milliseconds length, Audio::DataWindow& output, DecodeOptions options);
+    void processDecoded(Output& output, DecodeOptions options);
+
+    // Output to window - realtime decode path
+    class WindowOutput: public Output
+    {
+    public:
+        WindowOutput(Audio::DataWindow& window)
+            :mWindow(window)
+        {}
+        void add(const void* data, size_t bytes) override { mWindow.add(data, bytes); }
+
+    protected:
+        Audio::DataWindow& mWindow;
+    };
+
+    void produceSilence(std::chrono::milliseconds length, Output& output, DecodeOptions options);
+    void produceCNG(std::chrono::milliseconds length, Output& output, DecodeOptions options);
+
+    // Returns codec for payload type creating it on first use; null for unknown payload type
+    PCodec codecFor(int payloadType);
 
     // Calculate bitrate switch statistics for AMR codecs
     void updateAmrCodecStats(Codec* c);
 
-    DecodeResult decodeGapTo(Audio::DataWindow& output, DecodeOptions options);
-    DecodeResult decodePacketTo(Audio::DataWindow& output, DecodeOptions options, const std::shared_ptr<RtpBuffer::Packet>& p);
+    // Adaptive playout: accelerates or expands audio decoded to mAvailable from 'offset' bytes
+    // so buffered audio converges to estimated target delay
+    void adaptPlayout(size_t offset, DecodeOptions options);
+
+    // 'gap' carries packet following the gap (if known) and number of lost packets - used for in-band FEC recovery
+    DecodeResult decodeGapTo(Output& output, DecodeOptions options, const RtpBuffer::FetchResult& gap);
+    DecodeResult decodePacketTo(Output& output, DecodeOptions options, const std::shared_ptr<RtpBuffer::Packet>& p);
     DecodeResult decodeEmptyTo(Audio::DataWindow& output, DecodeOptions options);
 
+    // Consecutive packets decoded with single Codec::decodeBatch() call - see decodeBatchTo()
+    RtpBuffer::ResultList                   mBatch;
+    std::vector<std::span<const uint8_t>>   mBatchInputs;       // Codec frames of mBatch packets
+    std::vector<size_t>                     mBatchOwners;       // Index of mBatch packet per codec frame
+    std::vector<Codec::DecodeResult>        mBatchResults;
+
+    // Checks if packet continues the last one queued to mBatch (or the last decoded) with current codec:
+    // no codec switch, DTX pause, CNG or broken payload - so it needs no per-packet handling of decodePacketTo()
+    bool continuesBatch(const RtpBuffer::Packet& packet);
+
+    // Decodes mBatch packets at once and clears it; state left is the same as after decodePacketTo() for every packet
+    DecodeResult decodeBatchTo(Output& output, DecodeOptions options);
+
+    // Decoded bytes which fit scratch buffers after channel conversion and resampling
+    size_t batchCapacity();
+
     std::optional<std::chrono::steady_clock::time_point> mLastDecodeTimestamp;
     std::chrono::microseconds mIntervalBetweenDecode = 0us;
     size_t mDecodeCount = 0;
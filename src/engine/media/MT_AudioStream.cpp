@@ -5,8 +5,10 @@
 
 #include "MT_AudioStream.h"
 #include "MT_Dtmf.h"
+#include "MT_CodecStatePool.h"
 #include "../helper/HL_StreamState.h"
 #include "../helper/HL_Log.h"
+#include "../helper/HL_RtpMemoryPool.h"
 #include "../audio/Audio_Resampler.h"
 #include "../audio/Audio_Interface.h"
 
@@ -21,29 +23,60 @@
 //#define DUMP_SENDING_AUDIO
 
 using namespace MT;
-AudioStream::AudioStream(const CodecList::Settings& settings)
-    :mPacketTime(0), mEncodedTime(0), mCodecSettings(settings),
-      mRemoteTelephoneCodec(0), mRtpSession(), mTransmittingPayloadType(-1),
-      mRtpSender(mStat)
+AudioStream::SendPath::SendPath(NativeRtpSender& sender)
+    :mRtpDtmfSession(nullptr, &RtpMemoryPool::instance())
 {
-    mOutputBuffer.setCapacity(16384);
     mCapturedAudio.setCapacity(16384);
     mCaptureResampler8.start(AUDIO_CHANNELS, AUDIO_SAMPLERATE, 8000);
     mCaptureResampler16.start(AUDIO_CHANNELS, AUDIO_SAMPLERATE, 16000);
     mCaptureResampler32.start(AUDIO_CHANNELS, AUDIO_SAMPLERATE, 32000);
     mCaptureResampler48.start(AUDIO_CHANNELS, AUDIO_SAMPLERATE, 48000);
 
-    // Configure transmitter
+    jrtplib::RTPExternalTransmissionParams params(&sender, 0);
+    mRtpDtmfSession.Create(sessionParams(), &params, jrtplib::RTPTransmitter::ExternalProto);
+}
+
+AudioStream::SendPath::~SendPath()
+{
+    if (mRtpDtmfSession.IsActive())
+        mRtpDtmfSession.Destroy();
+
+    mCaptureResampler8.stop();
+    mCaptureResampler16.stop();
+    mCaptureResampler32.stop();
+    mCaptureResampler48.stop();
+}
+
+int AudioStream::SendPath::getSize() const
+{
+    return sizeof(*this) + mCapturedAudio.capacity()
+            + mCaptureResampler8.getSize() + mCaptureResampler16.getSize() + mCaptureResampler32.getSize() + mCaptureResampler48.getSize();
+}
+
+jrtplib::RTPSessionParams AudioStream::sessionParams()
+{
+    jrtplib::RTPSessionParams result;
+    result.SetAcceptOwnPackets(true);
+    result.SetMaximumPacketSize(MT_MAXRTPPACKET);
+    result.SetResolveLocalHostname(false);
+    result.SetUsePollThread(false);
+    result.SetOwnTimestampUnit(1/8000.0);
+    return result;
+}
+
+AudioStream::AudioStream(const CodecList::Settings& settings, bool receiveOnly)
+    :mPacketTime(0), mEncodedTime(0), mCodecSettings(settings),
+      mRemoteTelephoneCodec(0), mRtpSession(nullptr, &RtpMemoryPool::instance()),
+      mTransmittingPayloadType(-1),
+      mRtpSender(mSendStat, mStatGuard), mReceiveQueue(MT_RECEIVE_QUEUE_SIZE)
+{
+    // Configure transmitter; main session is needed for RTCP even if stream does not send
     jrtplib::RTPExternalTransmissionParams params(&mRtpSender, 0);
+    mRtpSession.Create(sessionParams(), &params, jrtplib::RTPTransmitter::ExternalProto);
+    mPlayoutWindow.setCapacity(32768);
 
-    jrtplib::RTPSessionParams sessionParams;
-    sessionParams.SetAcceptOwnPackets(true);
-    sessionParams.SetMaximumPacketSize(MT_MAXRTPPACKET);
-    sessionParams.SetResolveLocalHostname(false);
-    sessionParams.SetUsePollThread(false);
-    sessionParams.SetOwnTimestampUnit(1/8000.0);
-    mRtpSession.Create(sessionParams, &params, jrtplib::RTPTransmitter::ExternalProto);
-    mRtpDtmfSession.Create(sessionParams, &params, jrtplib::RTPTransmitter::ExternalProto);
+    if (!receiveOnly)
+        mSendPath = std::make_unique<SendPath>(mRtpSender);
 
     // Attach srtp session to sender
     mRtpSender.setSrtpSession(&mSrtpSession);
@@ -70,8 +103,7 @@ AudioStream::~AudioStream()
         delete streamIter->second;
     mStreamMap.clear();
 
-    if (mRtpDtmfSession.IsActive())
-        mRtpDtmfSession.Destroy();
+    mSendPath.reset();
     if (mRtpSession.IsActive())
         mRtpSession.Destroy();
 
@@ -83,10 +115,6 @@ AudioStream::~AudioStream()
     }
 #endif
 
-    mCaptureResampler8.stop();
-    mCaptureResampler16.stop();
-    mCaptureResampler32.stop();
-    mCaptureResampler48.stop();
     ICELogInfo(<< "Encoded " << mEncodedTime << " milliseconds of audio");
 
     if (mDumpStreams.mStreamForRecordingIncoming)
@@ -94,16 +122,24 @@ AudioStream::~AudioStream()
     if (mDumpStreams.mStreamForReadingOutgoing)
         mDumpStreams.mStreamForReadingOutgoing->close();
 
+    publishStatistics();
+    Statistics stat = statistics();
     if (mFinalStatistics)
-        *mFinalStatistics = mStat;
+        *mFinalStatistics = stat;
 
-    ICELogInfo(<< mStat.toString());
+    ICELogInfo(<< stat.toString());
+    ICELogInfo(<< RtpMemoryPool::instance().toString());
+    ICELogInfo(<< CodecStatePool::instance().toString());
 }
 
 void AudioStream::setDestination(const RtpPair<InternetAddress>& dest)
 {
     Lock l(mMutex);
-    Stream::setDestination(dest);
+    {
+        // mStat.mRemotePeer is read by publishStatistics() on playout thread
+        Lock sl(mStatGuard);
+        Stream::setDestination(dest);
+    }
     mRtpSender.setDestination(dest);
 }
 
@@ -112,12 +148,35 @@ void AudioStream::setTransmittingCodec(Codec::Factory& factory, int payloadType)
     ICELogInfo(<< "Selected codec " << factory.name() << "/" << factory.samplerate() << " for transmitting");
 
     Lock l(mMutex);
+    sendPath();
     mTransmittingCodec = factory.create();
     mTransmittingPayloadType = payloadType;
     if (mRtpSession.IsActive())
         mRtpSession.SetTimestampUnit(1.0 / mTransmittingCodec->samplerate());
 }
 
+AudioStream::SendPath& AudioStream::sendPath()
+{
+    if (!mSendPath)
+    {
+        ICELogDebug(<< "Create send path for audio stream");
+        mSendPath = std::make_unique<SendPath>(mRtpSender);
+    }
+    return *mSendPath;
+}
+
+int AudioStream::getSize()
+{
+    // Receivers are owned by playout thread - their size comes from its last tick
+    int result = sizeof(*this) + mPlayoutSize;
+
+    Lock l(mMutex);
+    if (mSendPath)
+        result += mSendPath->getSize();
+
+    return result;
+}
+
 PCodec AudioStream::transmittingCodec()
 {
     Lock l(mMutex);
@@ -143,6 +202,7 @@ void AudioStream::addData(const void* buffer, int bytes)
         mMediaObserver->onMedia(buffer, bytes, MT::Stream::MediaDirection::Outgoing, this, mMediaObserverTag);
 
     Codec* codec = nullptr;
+    SendPath* send = nullptr;
     {
         Lock l(mMutex);
         codec = mTransmittingCodec.get();
@@ -150,6 +210,7 @@ void AudioStream::addData(const void* buffer, int bytes)
             // ICELogDebug(<< "No transmitting codec selected.");
             return;
         }
+        send = &sendPath();
     }
 
     // Resample
@@ -157,16 +218,16 @@ void AudioStream::addData(const void* buffer, int bytes)
     Audio::Resampler* r = nullptr;
     switch (codec->samplerate())
     {
-    case 8000:   r = &mCaptureResampler8; break;
-    case 16000:  r = &mCaptureResampler16; break;
-    case 32000:  r = &mCaptureResampler32; break;
-    case 48000:  r = &mCaptureResampler48; break;
+    case 8000:   r = &send->mCaptureResampler8; break;
+    case 16000:  r = &send->mCaptureResampler16; break;
+    case 32000:  r = &send->mCaptureResampler32; break;
+    case 48000:  r = &send->mCaptureResampler48; break;
     default:
         assert(0);
     }
 
     size_t processedInput = 0;
-    dstlen = r->processBuffer(buffer, bytes, processedInput, mResampleBuffer, dstlen);
+    dstlen = r->processBuffer(buffer, bytes, processedInput, send->mResampleBuffer, dstlen);
     // ProcessedInput output value is ignored - because sample rate of input is always 8/16/32/48K - so all buffer is processed
 
     // See if we need stereo <-> mono conversions
@@ -174,29 +235,29 @@ void AudioStream::addData(const void* buffer, int bytes)
     if (codec->channels() != AUDIO_CHANNELS)
     {
         if (codec->channels() == 2)
-            stereolen = Audio::ChannelConverter::monoToStereo(mResampleBuffer, dstlen, mStereoBuffer, dstlen * 2);
+            stereolen = Audio::ChannelConverter::monoToStereo(send->mResampleBuffer, dstlen, send->mStereoBuffer, dstlen * 2);
         else
-            dstlen = Audio::ChannelConverter::stereoToMono(mResampleBuffer, dstlen, mResampleBuffer, dstlen / 2);
+            dstlen = Audio::ChannelConverter::stereoToMono(send->mResampleBuffer, dstlen, send->mResampleBuffer, dstlen / 2);
     }
 
     // See if inband dtmf audio should be sent instead
     ByteBuffer dtmf;
     if (mDtmfContext.type() == DtmfContext::Dtmf_Inband && mDtmfContext.getInband(AUDIO_MIC_BUFFER_LENGTH, codec->samplerate(), dtmf))
-        mCapturedAudio.add(dtmf.data(), dtmf.size());
+        send->mCapturedAudio.add(dtmf.data(), dtmf.size());
     else
-        mCapturedAudio.add(stereolen ? mStereoBuffer : mResampleBuffer, stereolen ? stereolen : dstlen);
+        send->mCapturedAudio.add(stereolen ? send->mStereoBuffer : send->mResampleBuffer, stereolen ? stereolen : dstlen);
 
     // See if it is time to send RFC2833 tone
     ByteBuffer rfc2833, stopPacket;
     if (mDtmfContext.type() == DtmfContext::Dtmf_Rfc2833 && mDtmfContext.getRfc2833(AUDIO_MIC_BUFFER_LENGTH, rfc2833, stopPacket))
     {
         if (rfc2833.size())
-            mRtpDtmfSession.SendPacket(rfc2833.data(), rfc2833.size(), mRemoteTelephoneCodec, true, AUDIO_MIC_BUFFER_LENGTH * 8);
+            send->mRtpDtmfSession.SendPacket(rfc2833.data(), rfc2833.size(), mRemoteTelephoneCodec, true, AUDIO_MIC_BUFFER_LENGTH * 8);
 
         if (stopPacket.size())
         {
             for (int i=0; i<3; i++)
-                mRtpDtmfSession.SendPacket(stopPacket.data(), stopPacket.size(), mRemoteTelephoneCodec, true, AUDIO_MIC_BUFFER_LENGTH * 8);
+                send->mRtpDtmfSession.SendPacket(stopPacket.data(), stopPacket.size(), mRemoteTelephoneCodec, true, AUDIO_MIC_BUFFER_LENGTH * 8);
         }
     }
 
@@ -205,13 +266,13 @@ void AudioStream::addData(const void* buffer, int bytes)
     int packetTime = mPacketTime ? mPacketTime : codec->frameTime();
 
     // Make stereo version if required
-    for (int i=0; i<mCapturedAudio.filled() / codec->pcmLength(); i++)
+    for (int i=0; i<send->mCapturedAudio.filled() / codec->pcmLength(); i++)
     {
         if (mSendingDump)
-            mSendingDump->write((const char*)mCapturedAudio.data() + codec->pcmLength() * i, codec->pcmLength());
+            mSendingDump->write((const char*)send->mCapturedAudio.data() + codec->pcmLength() * i, codec->pcmLength());
 
-        auto r = codec->encode({(const uint8_t*)mCapturedAudio.data() + codec->pcmLength()*i, (size_t)codec->pcmLength()},
-                                 {(uint8_t*)mFrameBuffer, MT_MAXAUDIOFRAME});
+        auto r = codec->encode({(const uint8_t*)send->mCapturedAudio.data() + codec->pcmLength()*i, (size_t)codec->pcmLength()},
+                                 {(uint8_t*)send->mFrameBuffer, MT_MAXAUDIOFRAME});
         
         // Counter of processed input bytes of raw pcm data from microphone
         processed += codec->pcmLength();
@@ -220,36 +281,60 @@ void AudioStream::addData(const void* buffer, int bytes)
 
         if (r.mEncoded)
         {
-            mEncodedAudio.appendBuffer(mFrameBuffer, r.mEncoded);
+            send->mEncodedAudio.appendBuffer(send->mFrameBuffer, r.mEncoded);
             if (packetTime <= encodedTime)
             {
                 // Time to send packet
-                ICELogMedia(<< "Sending RTP packet pt = " << mTransmittingPayloadType << ", plength = " << (int)mEncodedAudio.size() << " to ");
-                mRtpSession.SendPacketEx(mEncodedAudio.data(), mEncodedAudio.size(), mTransmittingPayloadType, false,
+                ICELogMedia(<< "Sending RTP packet pt = " << mTransmittingPayloadType << ", plength = " << (int)send->mEncodedAudio.size() << " to ");
+                mRtpSession.SendPacketEx(send->mEncodedAudio.data(), send->mEncodedAudio.size(), mTransmittingPayloadType, false,
                                          packetTime * codec->samplerate()/1000, 0, nullptr, 0);
-                mEncodedAudio.clear();
+                send->mEncodedAudio.clear();
                 encodedTime = 0;
             }
         }
     }
     if (processed > 0)
-        mCapturedAudio.erase(processed);
+        send->mCapturedAudio.erase(processed);
+}
+
+void AudioStream::processReceived()
+{
+    std::shared_ptr<jrtplib::RTPPacket> packet;
+    while (mReceiveQueue.pop(packet))
+    {
+        // Find right handler for rtp stream
+        SingleAudioStream* rtpStream = nullptr;
+        auto streamIter = mStreamMap.find(packet->GetSSRC());
+        if (streamIter == mStreamMap.end()) {
+            rtpStream = new SingleAudioStream(mCodecSettings, mStat);
+            mStreamMap.insert({packet->GetSSRC(), rtpStream});
+        }
+        else
+            rtpStream = streamIter->second;
+
+        // Process incoming data packet
+        rtpStream->process(packet);
+    }
 }
 
 void AudioStream::copyDataTo(Audio::Mixer& mixer, int needed)
 {
-    // mStreamMap is also mutated from the network thread (dataArrived)
-    Lock l(mMutex);
+    // No lock here: network thread hands packets over via mReceiveQueue, so decode never blocks it
+    processReceived();
 
-    // Local audio mixer - used to send audio to media observer
-    Audio::Mixer localMixer;
-    Audio::DataWindow forObserver;
+    // Single SSRC goes to media observer directly, several ones are mixed first
+    bool observerMix = mMediaObserver && mStreamMap.size() > 1;
+    if (observerMix && !mObserverMixer)
+    {
+        mObserverMixer = std::make_unique<Audio::Mixer>();
+        mObserverOutput.setCapacity(32768);
+    }
 
     // Iterate
     for (auto& streamIter: mStreamMap)
     {
-        Audio::DataWindow w;
-        w.setCapacity(32768);
+        Audio::DataWindow& w = mPlayoutWindow;
+        w.clear();
 
         SingleAudioStream* sas = streamIter.second;
         if (sas)
@@ -277,24 +362,43 @@ void AudioStream::copyDataTo(Audio::Mixer& mixer, int needed)
                 }
                 mixer.addPcm(this, streamIter.first, w, AUDIO_SAMPLERATE, false);
 
+                if (observerMix)
+                    mObserverMixer->addPcm(this, streamIter.first, w, AUDIO_SAMPLERATE, false);
+                else
                 if (mMediaObserver)
-                    localMixer.addPcm(this, streamIter.first, w, AUDIO_SAMPLERATE, false);
+                    mMediaObserver->onMedia(w.data(), w.filled(), MT::Stream::MediaDirection::Incoming, this, mMediaObserverTag);
             }
         }
     }
 
-    if (mMediaObserver)
+    if (observerMix)
     {
-        int mixedBytes = localMixer.mixAndGetPcm(forObserver);
+        int mixedBytes = mObserverMixer->mixAndGetPcm(mObserverOutput);
         if (mixedBytes > 0)
-            mMediaObserver->onMedia(forObserver.data(), mixedBytes, MT::Stream::MediaDirection::Incoming, this, mMediaObserverTag);
+            mMediaObserver->onMedia(mObserverOutput.data(), mixedBytes, MT::Stream::MediaDirection::Incoming, this, mMediaObserverTag);
     }
+
+    // Publish memory owned by this thread for getSize()
+    int playoutSize = mMirrorBuffer.capacity() + mPlayoutWindow.capacity();
+    if (mObserverMixer)
+        playoutSize += sizeof(Audio::Mixer) + mObserverOutput.capacity();
+    for (const auto& streamIter: mStreamMap)
+        playoutSize += streamIter.second->getSize();
+    mPlayoutSize = playoutSize;
+
+    publishStatistics();
+}
+
+void AudioStream::publishStatistics()
+{
+    // Assignment reuses storage of previous copy, so steady playout tick does not allocate here
+    Lock l(mStatGuard);
+    mPlayoutStat = mStat;
 }
 
-void AudioStream::dataArrived(PDatagramSocket s, const void* buffer, int length, InternetAddress& source)
+void AudioStream::dataArrived(PDatagramSocket s, const void* buffer, int length, InternetAddress& source, DatagramTime receiveTime)
 {
-    // Protects mStreamMap (also iterated by copyDataTo on the audio thread)
-    // and the receive/decrypt buffers.
+    // Protects jrtplib session and the receive/decrypt buffers; playout thread does not take it
     Lock l(mMutex);
 
     jrtplib::RTPIPv6Address addr6;
@@ -309,26 +413,80 @@ void AudioStream::dataArrived(PDatagramSocket s, const void* buffer, int length,
         return;
     }
 
-    // Copy incoming data to temp buffer to perform possible srtp unprotect
-    int receiveLength = length;
-    memcpy(mReceiveBuffer, buffer, length);
+    // Datagrams kernel dropped on our socket before this one arrived
+    if (s)
+        mReceiveStat.mLocalDrops += s->takeLocalDrops();
+
+    // Time spent by datagram in socket queue and reactor before it got here
+    mReceiveStat.processQueueDelay(std::chrono::duration<float, std::milli>(std::chrono::system_clock::now() - receiveTime).count());
+
+    // jrtplib stamps packet with kernel receive time, so queueing delay is not counted as jitter
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::microseconds>(receiveTime.time_since_epoch());
+    jrtplib::RTPTime rtpReceiveTime((uint32_t)(sinceEpoch.count() / 1000000), (uint32_t)(sinceEpoch.count() % 1000000));
+
+    // Plain packet is used in place. SRTP packet is copied once into pooled buffer and decrypted there in place;
+    // native receive turns that buffer into RTP packet, so the payload is not copied again.
+    const void* packet = buffer;
+    size_t packetLength = length;
+    std::unique_ptr<uint8_t, void(*)(uint8_t*)> decrypted(nullptr, [](uint8_t* p) { RtpMemoryPool::instance().release(p); });
 
     if (mSrtpSession.active())
     {
+        decrypted.reset(static_cast<uint8_t*>(RtpMemoryPool::instance().allocate(length)));
+        memcpy(decrypted.get(), buffer, length);
+
         bool srtpResult;
-        size_t srcLength = length; size_t dstLength = sizeof mSrtpDecodeBuffer;
-        if (RtpHelper::isRtp(mReceiveBuffer, receiveLength))
-            srtpResult = mSrtpSession.unprotectRtp(mReceiveBuffer, srcLength, mSrtpDecodeBuffer, &dstLength);
+        size_t dstLength = length;
+        if (RtpHelper::isRtp(buffer, length))
+            srtpResult = mSrtpSession.unprotectRtp(decrypted.get(), length, decrypted.get(), &dstLength);
         else
-            srtpResult = mSrtpSession.unprotectRtcp(mReceiveBuffer, srcLength, mSrtpDecodeBuffer, &dstLength);
+            srtpResult = mSrtpSession.unprotectRtcp(decrypted.get(), length, decrypted.get(), &dstLength);
         if (!srtpResult)
         {
             ICELogError(<<"Cannot decrypt SRTP packet.");
             return;
         }
 
-        memcpy(mReceiveBuffer, mSrtpDecodeBuffer, dstLength);
-        receiveLength = dstLength;
+        packet = decrypted.get();
+        packetLength = dstLength;
+    }
+
+    mReceiveStat.mReceived += length;
+    auto& perDst = mReceiveStat.mPerDestination[source];
+    perDst.mReceivedBytes += length;
+    bool isRtp = RtpHelper::isRtp(packet, packetLength);
+    if (isRtp)
+    {
+        if (!mReceiveStat.mFirstRtpTime)
+            mReceiveStat.mFirstRtpTime = std::chrono::steady_clock::now();
+        mReceiveStat.mReceivedRtp++;
+        perDst.mReceivedRtp++;
+    }
+    else
+    {
+        mReceiveStat.mReceivedRtcp++;
+        perDst.mReceivedRtcp++;
+    }
+
+    // Native receive: media packets skip injection, jrtplib source table and packet list
+    if (isRtp && mCodecSettings.mNativeRtpReceive)
+    {
+        RtpPacketView view;
+        if (!RtpHelper::parseRtp(packet, packetLength, view))
+        {
+            mReceiveStat.mIllegalRtp++;
+            return;
+        }
+
+        uint32_t seqno = mSequenceExtenders[view.mSsrc].extend(view.mSeqno);
+        std::shared_ptr<jrtplib::RTPPacket> rtp;
+        if (decrypted)
+            rtp = RtpHelper::adoptPacket(decrypted.release(), packetLength, seqno, rtpReceiveTime, &RtpMemoryPool::instance());
+        else
+            rtp = RtpHelper::makePacket(view, seqno, rtpReceiveTime, &RtpMemoryPool::instance());
+        if (rtp)
+            queueReceived(rtp);
+        return;
     }
 
     switch (source.family())
@@ -337,81 +495,82 @@ void AudioStream::dataArrived(PDatagramSocket s, const void* buffer, int length,
         addr4.SetIP(source.sockaddr4()->sin_addr.s_addr);
         addr4.SetPort(source.port());
         ICELogMedia(<< "Injecting RTP/RTCP packet into jrtplib");
-        info->GetPacketInjector()->InjectRTPorRTCP(mReceiveBuffer, receiveLength, addr4);
+        info->GetPacketInjector()->InjectRTPorRTCP(packet, packetLength, addr4, rtpReceiveTime);
         break;
 
     case AF_INET6:
         addr6.SetIP(source.sockaddr6()->sin6_addr);
         addr6.SetPort(source.port());
         ICELogMedia(<< "Injecting RTP/RTCP packet into jrtplib");
-        info->GetPacketInjector()->InjectRTPorRTCP(mReceiveBuffer, receiveLength, addr6);
+        info->GetPacketInjector()->InjectRTPorRTCP(packet, packetLength, addr6, rtpReceiveTime);
         break;
 
     default:
         assert(0);
     }
 
-    mStat.mReceived += length;
-    auto& perDst = mStat.mPerDestination[source];
-    perDst.mReceivedBytes += length;
-    if (RtpHelper::isRtp(mReceiveBuffer, receiveLength))
-    {
-        if (!mStat.mFirstRtpTime)
-            mStat.mFirstRtpTime = std::chrono::steady_clock::now();
-        mStat.mReceivedRtp++;
-        perDst.mReceivedRtp++;
-    }
-    else
+    mRtpSession.Poll(); // maybe it is extra with external transmitter
+
+    // Only RTCP reaches jrtplib in native mode - take RTT from its report blocks
+    if (mCodecSettings.mNativeRtpReceive)
     {
-        mStat.mReceivedRtcp++;
-        perDst.mReceivedRtcp++;
+        bool hasSource = mRtpSession.GotoFirstSource();
+        while (hasSource)
+        {
+            processRtt(mRtpSession.GetCurrentSourceInfo()->INF_GetRoundtripTime().GetDouble());
+            hasSource = mRtpSession.GotoNextSource();
+        }
+        return;
     }
 
-    mRtpSession.Poll(); // maybe it is extra with external transmitter
     bool hasData = mRtpSession.GotoFirstSourceWithData();
     while (hasData)
     {
-        std::shared_ptr<jrtplib::RTPPacket> packet(mRtpSession.GetNextPacket());
+        // Session allocated the packet from RtpMemoryPool; it may be released on playout thread after the session is gone
+        std::shared_ptr<jrtplib::RTPPacket> packet(mRtpSession.GetNextPacket(),
+                                                   [](jrtplib::RTPPacket* p) { jrtplib::RTPDelete(p, &RtpMemoryPool::instance()); });
         if (packet)
         {
             ICELogMedia(<< "jrtplib returned packet");
 
-            // Find right handler for rtp stream
-            SingleAudioStream* rtpStream = nullptr;
-            auto streamIter = mStreamMap.find(packet->GetSSRC());
-            if (streamIter == mStreamMap.end()) {
-                rtpStream = new SingleAudioStream(mCodecSettings, mStat);
-                mStreamMap.insert({packet->GetSSRC(), rtpStream});
-            }
-            else
-                rtpStream = streamIter->second;
-
-            // Process incoming data packet
-            rtpStream->process(packet);
-
-            // RTT sanity filter: jrtplib's INF_GetRoundtripTime() does the
-            // RFC 3550 §6.4.1 math but omits clock-skew / outlier guards;
-            // without these, a skewed or buggy peer can poison mRttDelay
-            // (and therefore the Id term in MOS).
-            double rtt = mRtpSession.GetCurrentSourceInfo()->INF_GetRoundtripTime().GetDouble();
-            if (rtt > 0 && rtt < 30.0)  // reject "RTT not making any sense" (>30s)
-            {
-                // Once an average is established, cap a new sample at 3x mean
-                // so a single outlier can't skew the running RTT.
-                constexpr double kRttNormalizeFactor = 3.0;
-                const double meanRtt = mStat.mRttDelay.average();
-                if (mStat.mRttDelay.is_initialized() && meanRtt > 0.0 &&
-                    rtt > meanRtt * kRttNormalizeFactor)
-                {
-                    rtt = meanRtt * kRttNormalizeFactor;
-                }
-                mStat.mRttDelay.process(rtt);
-            }
+            queueReceived(packet);
+            processRtt(mRtpSession.GetCurrentSourceInfo()->INF_GetRoundtripTime().GetDouble());
         }
         hasData = mRtpSession.GotoNextSourceWithData();
     }
 }
 
+void AudioStream::queueReceived(const std::shared_ptr<jrtplib::RTPPacket>& packet)
+{
+    // Decoding and jitter buffering happen on playout thread
+    if (!mReceiveQueue.push(std::shared_ptr<jrtplib::RTPPacket>(packet)))
+    {
+        ICELogMedia(<< "Receive queue is full, packet is dropped");
+        mReceiveStat.mPacketDropped++;
+    }
+}
+
+void AudioStream::processRtt(double rtt)
+{
+    // RTT sanity filter: jrtplib's INF_GetRoundtripTime() does the
+    // RFC 3550 §6.4.1 math but omits clock-skew / outlier guards;
+    // without these, a skewed or buggy peer can poison mRttDelay
+    // (and therefore the Id term in MOS).
+    if (rtt > 0 && rtt < 30.0)  // reject "RTT not making any sense" (>30s)
+    {
+        // Once an average is established, cap a new sample at 3x mean
+        // so a single outlier can't skew the running RTT.
+        constexpr double kRttNormalizeFactor = 3.0;
+        const double meanRtt = mReceiveStat.mRttDelay.average();
+        if (mReceiveStat.mRttDelay.is_initialized() && meanRtt > 0.0 &&
+            rtt > meanRtt * kRttNormalizeFactor)
+        {
+            rtt = meanRtt * kRttNormalizeFactor;
+        }
+        mReceiveStat.mRttDelay.process(rtt);
+    }
+}
+
 void AudioStream::setState(unsigned state)
 {
     Stream::setState(state);
@@ -461,6 +620,52 @@ void AudioStream::setupMirror(bool enable)
     mMirror = enable;
 }
 
+Statistics AudioStream::statistics()
+{
+    // mStat is written by playout thread without lock - use its last published copy
+    Statistics result;
+    {
+        Lock l(mStatGuard);
+        result = mPlayoutStat;
+
+        const Statistics& s = mSendStat;
+        result.mSent        += s.mSent;
+        result.mSentRtp     += s.mSentRtp;
+        result.mSentRtcp    += s.mSentRtcp;
+        for (const auto& [addr, counts]: s.mPerDestination)
+        {
+            auto& dst = result.mPerDestination[addr];
+            dst.mSentRtp    += counts.mSentRtp;
+            dst.mSentRtcp   += counts.mSentRtcp;
+            dst.mSentBytes  += counts.mSentBytes;
+        }
+    }
+
+    Lock l(mMutex);
+    const Statistics& r = mReceiveStat;
+    result.mReceived        += r.mReceived;
+    result.mReceivedRtp     += r.mReceivedRtp;
+    result.mReceivedRtcp    += r.mReceivedRtcp;
+    result.mIllegalRtp      += r.mIllegalRtp;
+    result.mPacketDropped   += r.mPacketDropped;
+    result.mLocalDrops      += r.mLocalDrops;
+    result.mQueueDelay      = r.mQueueDelay;
+    result.mQueueDelayHistogram = r.mQueueDelayHistogram;
+    result.mRttDelay        = r.mRttDelay;
+    result.mFirstRtpTime    = r.mFirstRtpTime;
+
+    // Received traffic is counted by network thread
+    for (const auto& [addr, counts]: r.mPerDestination)
+    {
+        auto& dst = result.mPerDestination[addr];
+        dst.mReceivedRtp   += counts.mReceivedRtp;
+        dst.mReceivedRtcp  += counts.mReceivedRtcp;
+        dst.mReceivedBytes += counts.mReceivedBytes;
+    }
+
+    return result;
+}
+
 void AudioStream::setFinalStatisticsOutput(Statistics* stats)
 {
     mFinalStatistics = stats;
@@ -29,7 +29,9 @@ namespace MT
 class AudioStream: public Stream
 {
 public:
-    AudioStream(const CodecList::Settings& codecSettings);
+    // Receive-only stream allocates encoder buffers, capture resamplers and DTMF session
+    // on first setTransmittingCodec() - it saves memory when monitoring many calls.
+    AudioStream(const CodecList::Settings& codecSettings, bool receiveOnly = false);
     ~AudioStream();
 
     void setDestination(const RtpPair<InternetAddress>& dest) override;
@@ -46,7 +48,7 @@ public:
     void copyDataTo(Audio::Mixer& mixer, int needed);
 
     // Called to process incoming rtp packet
-    void dataArrived(PDatagramSocket s, const void* buffer, int length, InternetAddress& source) override;
+    void dataArrived(PDatagramSocket s, const void* buffer, int length, InternetAddress& source, DatagramTime receiveTime) override;
     void setSocket(const RtpPair<PDatagramSocket>& socket) override;
     void setState(unsigned state) override;
     
@@ -59,36 +61,60 @@ public:
 
     void setFinalStatisticsOutput(Statistics* stats);
 
+    // Merges sender and network thread counters into last published playout thread ones
+    Statistics statistics() override;
+
+    // Approximate memory used by stream and its receivers, bytes. Part owned by playout thread is as of its last tick.
+    int getSize();
+
 protected:
-    Audio::DataWindow mCapturedAudio;     // Data from microphone
-    Audio::DataWindow mStereoCapturedAudio;
-    char mIncomingPcmBuffer[AUDIO_MIC_BUFFER_SIZE] = {0}; // Temporary buffer to allow reading from file
-    char mResampleBuffer[AUDIO_MIC_BUFFER_SIZE*8] = {0};  // Temporary buffer to hold data
-    char mStereoBuffer[AUDIO_MIC_BUFFER_SIZE*16] = {0};   // Temporary buffer to hold data converted to stereo
+    // Everything needed to encode and send captured audio
+    struct SendPath
+    {
+        SendPath(NativeRtpSender& sender);
+        ~SendPath();
+
+        Audio::DataWindow mCapturedAudio;               // Data from microphone
+        char mResampleBuffer[AUDIO_MIC_BUFFER_SIZE*8] = {0};  // Temporary buffer to hold data
+        char mStereoBuffer[AUDIO_MIC_BUFFER_SIZE*16] = {0};   // Temporary buffer to hold data converted to stereo
+        char mFrameBuffer[MT_MAXAUDIOFRAME];            // Temporary buffer to hold results of encoder
+        ByteBuffer mEncodedAudio;                       // Encoded frame(s)
+        jrtplib::RTPSession mRtpDtmfSession;            // Rtp dtmf session
+        Audio::Resampler  mCaptureResampler8,
+                          mCaptureResampler16,
+                          mCaptureResampler32,
+                          mCaptureResampler48;
+
+        int getSize() const;
+    };
+
+    std::unique_ptr<SendPath> mSendPath;            // Created on demand for receive-only stream
     PCodec mTransmittingCodec;                      // Current encoding codec
     int mTransmittingPayloadType = -1;              // Payload type to mark outgoing packets
     int mPacketTime = 0;                            // Required packet time
-    char mFrameBuffer[MT_MAXAUDIOFRAME];            // Temporary buffer to hold results of encoder
-    ByteBuffer mEncodedAudio;                       // Encoded frame(s)
     int mEncodedTime = 0;                           // Time length of encoded audio
     CodecList::Settings mCodecSettings;             // Configuration for stream
     Mutex mMutex;                      	            // Mutex
+    Mutex mStatGuard;                               // Protects mSendStat and mPlayoutStat
+    Statistics mSendStat;                           // Counters of sender (mic thread); protected by mStatGuard
+    Statistics mPlayoutStat;                        // Copy of mStat published by playout thread; protected by mStatGuard
     int mRemoteTelephoneCodec;                      // Payload for remote telephone codec
     jrtplib::RTPSession mRtpSession;                // Rtp session
-    jrtplib::RTPSession mRtpDtmfSession;            // Rtp dtmf session
     NativeRtpSender mRtpSender;
-    AudioStreamMap mStreamMap;                      // Map of media streams. Key is RTP's SSRC value.
-    Audio::DataWindow mOutputBuffer;
+    AudioStreamMap mStreamMap;                      // Map of media streams. Key is RTP's SSRC value. Used by playout thread only.
+    Statistics mReceiveStat;                        // Counters of network thread (dataArrived); protected by mMutex. mStat belongs to playout thread.
+    SpscQueue<std::shared_ptr<jrtplib::RTPPacket>> mReceiveQueue;   // Packets parsed by network thread, waiting for playout thread
+    std::map<uint32_t, RtpSequenceExtender> mSequenceExtenders;     // Per-SSRC, used by native RTP receive
+
+    // Playout scratch - reused by copyDataTo() so playout tick does not allocate
+    Audio::DataWindow mPlayoutWindow;               // Decoded audio of current SSRC
+    std::unique_ptr<Audio::Mixer> mObserverMixer;   // Mixes SSRCs for media observer; created when more than one SSRC is observed
+    Audio::DataWindow mObserverOutput;
+    std::atomic<int> mPlayoutSize = 0;              // Memory of receivers and playout scratch; published by playout thread for getSize()
 #if defined(USE_RTPDUMP)
     RtpDump* mRtpDump = nullptr;
 #endif
-    Audio::Resampler  mCaptureResampler8,
-                      mCaptureResampler16,
-                      mCaptureResampler32,
-                      mCaptureResampler48;
     DtmfContext mDtmfContext;
-    char mReceiveBuffer[MAX_VALID_UDPPACKET_SIZE] = {0},
-         mSrtpDecodeBuffer[MAX_VALID_UDPPACKET_SIZE] = {0};
 
     struct
     {
@@ -106,6 +132,24 @@ protected:
 
     Statistics* mFinalStatistics = nullptr;
 
+    // Copies mStat to mPlayoutStat. Called by playout thread (or when it is stopped).
+    void publishStatistics();
+
+    // Returns send path creating it if needed. Called with mMutex locked.
+    SendPath& sendPath();
+
+    // Common parameters for RTP sessions
+    static jrtplib::RTPSessionParams sessionParams();
+
+    // Queues RTP packet to playout thread
+    void queueReceived(const std::shared_ptr<jrtplib::RTPPacket>& packet);
+
+    // Filters RTT reported by jrtplib and adds it to statistics
+    void processRtt(double rtt);
+
+    // Moves packets from mReceiveQueue to per-SSRC streams. Called from playout thread.
+    void processReceived();
+
     // bool decryptSrtp(void* data, int* len);
 };
 };
@@ -97,6 +97,9 @@ void Terminal::onMicData(const Audio::Format& f, const void* buffer, int length)
   StreamList sl;
   mAudioList.copyTo(&sl);
 
+  // Packets produced by streams are sent together when the tick is over
+  DatagramSendQueue::Scope sendScope(mSendQueue);
+
   // Iterate streams. See what of them requires microphone data.
   for (int frameIndex=0; frameIndex < mCapturedAudio.filled() / AUDIO_MIC_BUFFER_SIZE; frameIndex++)
   {
@@ -13,6 +13,7 @@
 #include "../audio/Audio_DevicePair.h"
 #include "../audio/Audio_Mixer.h"
 #include "../helper/HL_VariantMap.h"
+#include "../helper/HL_NetworkSocket.h"
 
 namespace MT
 {
@@ -38,6 +39,7 @@ namespace MT
     Audio::PDevicePair mAudioPair;
     Audio::Mixer mAudioMixer;
     Audio::DataWindow mCapturedAudio;
+    DatagramSendQueue mSendQueue;     // Collects RTP/RTCP produced by all streams during microphone tick
 
     void deviceChanged(Audio::DevicePair* dp);
     void onMicData(const Audio::Format& f, const void* buffer, int length);
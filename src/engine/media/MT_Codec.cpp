@@ -5,8 +5,34 @@
 
 #include "MT_Codec.h"
 
+#include <algorithm>
+#include <mutex>
+
 using namespace MT;
 
+void Codec::captureInfo()
+{
+    // Codec may be queried from several threads (playout, signalling) - first call fills the cache once
+    static std::mutex guard;
+    std::unique_lock<std::mutex> l(guard);
+    if (mInfoReady.load(std::memory_order_relaxed))
+        return;
+
+    mInfo = info();
+    mInfoReady.store(true, std::memory_order_release);
+}
+
+size_t Codec::decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results)
+{
+    size_t count = std::min(inputs.size(), results.size()), offset = 0, i = 0;
+    for (; i < count && output.size() - offset >= (size_t)pcmLength(); i++)
+    {
+        results[i] = decode(inputs[i], output.subspan(offset));
+        offset += results[i].mDecoded;
+    }
+    return i;
+}
+
 int Codec::Factory::channels()
 {
     return 1;
@@ -8,6 +8,7 @@
 
 #include <map>
 #include <span>
+#include <atomic>
 
 #include "resiprocate/resip/stack/SdpContents.hxx"
 #include "../helper/HL_Types.h"
@@ -54,20 +55,28 @@ public:
         int mRtpLength = 0;     // In bytes
         float mTimestampUnit = 0.0f;
     };
-    // Returns information about this codec instance
+    // Returns information about this codec instance. It must not change after construction.
     virtual Info info() = 0;
 
-    // Helper functions to return information - they are based on info() method
-    int pcmLength()         { return info().mPcmLength;  }
-    int rtpLength()         { return info().mRtpLength;  }
-    int channels()          { return info().mChannels;   }
-    int samplerate()        { return info().mSamplerate; }
-    int frameTime()         { return info().mFrameTime;  }
-    std::string name()      { return info().mName;       }
-    float timestampUnit()   { return info().mTimestampUnit == 0.0f ? 1.0f / info().mSamplerate : info().mTimestampUnit; }
+    // Result of info() captured on first use; helpers below are called per packet / frame
+    const Info& cachedInfo()
+    {
+        if (!mInfoReady.load(std::memory_order_acquire))
+            captureInfo();
+        return mInfo;
+    }
+
+    // Helper functions to return information - they are based on cached info() result
+    int pcmLength()                 { return cachedInfo().mPcmLength;  }
+    int rtpLength()                 { return cachedInfo().mRtpLength;  }
+    int channels()                  { return cachedInfo().mChannels;   }
+    int samplerate()                { return cachedInfo().mSamplerate; }
+    int frameTime()                 { return cachedInfo().mFrameTime;  }
+    const std::string& name()       { return cachedInfo().mName;       }
+    float timestampUnit()           { const Info& i = cachedInfo(); return i.mTimestampUnit == 0.0f ? 1.0f / i.mSamplerate : i.mTimestampUnit; }
 
     Audio::Format getAudioFormat() {
-        return Audio::Format(this->info().mSamplerate, this->info().mChannels);
+        return Audio::Format(cachedInfo().mSamplerate, cachedInfo().mChannels);
     }
 
     // Returns size of encoded data (RTP) in bytes
@@ -85,9 +94,27 @@ public:
     };
     virtual DecodeResult decode(std::span<const uint8_t> input, std::span<uint8_t> output) = 0;
 
+    // Decodes several payloads in order; their PCM follows each other in output without gaps.
+    // results receives decode() result per input and must be at least inputs.size() long.
+    // Stops before input which may not fit into the rest of output; returns number of decoded inputs.
+    // Default implementation calls decode() per input and reserves pcmLength() for each of them.
+    virtual size_t decodeBatch(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> output, std::span<DecodeResult> results);
+
     // Returns size of produced data (PCM signed short) in bytes
     virtual size_t plc(int lostFrames, std::span<uint8_t> output) = 0;
 
+    // Recovers packet lost right before 'input' from in-band FEC data carried by 'input'.
+    // Returns size of produced data (PCM signed short) in bytes; 0 if codec / packet has no FEC.
+    virtual size_t decodeFec(std::span<const uint8_t> /*input*/, std::span<uint8_t> /*output*/) { return 0; }
+
+    // Returns true if 'input' carries in-band FEC data for decodeFec(); it does not touch decoder state
+    virtual bool hasFec(std::span<const uint8_t> /*input*/) { return false; }
+
+private:
+    Info                mInfo;
+    std::atomic<bool>   mInfoReady = false;
+
+    void captureInfo();
 };
 }
 #endif
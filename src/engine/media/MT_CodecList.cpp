@@ -282,8 +282,8 @@ CodecList::Settings CodecList::Settings::parseSdp(const std::list<resip::Codec>&
 
 bool CodecList::Settings::operator == (const Settings& rhs) const
 {
-    if (std::tie(mWrapIuUP, mSkipDecode, mIsac16KPayloadType, mIsac32KPayloadType, mIlbc20PayloadType, mIlbc30PayloadType, mGsmFrPayloadType, mGsmFrPayloadLength, mGsmEfrPayloadType, mGsmHrPayloadType, mTelephoneEvent) !=
-        std::tie(rhs.mWrapIuUP, rhs.mSkipDecode, rhs.mIsac16KPayloadType, rhs.mIsac32KPayloadType, rhs.mIlbc20PayloadType, rhs.mIlbc30PayloadType, rhs.mGsmFrPayloadType, rhs.mGsmFrPayloadLength, rhs.mGsmEfrPayloadType, rhs.mGsmHrPayloadType, rhs.mTelephoneEvent))
+    if (std::tie(mWrapIuUP, mSkipDecode, mAdaptivePlayout, mNativeRtpReceive, mIsac16KPayloadType, mIsac32KPayloadType, mIlbc20PayloadType, mIlbc30PayloadType, mGsmFrPayloadType, mGsmFrPayloadLength, mGsmEfrPayloadType, mGsmHrPayloadType, mTelephoneEvent) !=
+        std::tie(rhs.mWrapIuUP, rhs.mSkipDecode, rhs.mAdaptivePlayout, rhs.mNativeRtpReceive, rhs.mIsac16KPayloadType, rhs.mIsac32KPayloadType, rhs.mIlbc20PayloadType, rhs.mIlbc30PayloadType, rhs.mGsmFrPayloadType, rhs.mGsmFrPayloadLength, rhs.mGsmEfrPayloadType, rhs.mGsmHrPayloadType, rhs.mTelephoneEvent))
         return false;
 
     if (mAmrNbOctetPayloadType != rhs.mAmrNbOctetPayloadType)
@@ -426,6 +426,64 @@ PCodec CodecList::createCodecByPayloadType(int payloadType)
     return {};
 }
 
+// ----------------------------------------
+
+CodecRegistry::CodecRegistry(const CodecList::Settings& settings)
+    :mList(settings)
+{
+    for (int i = 0; i < mList.count(); i++)
+        mFactories.emplace(mList.codecAt(i).payloadType(), &mList.codecAt(i));
+}
+
+std::shared_ptr<const CodecRegistry> CodecRegistry::get(const CodecList::Settings& settings)
+{
+    // Number of live registries is small - linear search is fine. Registry goes away with its last receiver.
+    static std::mutex guard;
+    static std::vector<std::weak_ptr<const CodecRegistry>> registries;
+
+    std::unique_lock<std::mutex> l(guard);
+    std::shared_ptr<const CodecRegistry> result;
+    for (auto iter = registries.begin(); iter != registries.end();)
+    {
+        std::shared_ptr<const CodecRegistry> r = iter->lock();
+        if (!r)
+        {
+            iter = registries.erase(iter);
+            continue;
+        }
+        if (!result && r->settings() == settings)
+            result = r;
+        ++iter;
+    }
+    if (result)
+        return result;
+
+    result.reset(new CodecRegistry(settings));
+    registries.push_back(result);
+    return result;
+}
+
+PCodec CodecRegistry::create(int payloadType) const
+{
+    auto iter = mFactories.find(payloadType);
+    if (iter == mFactories.end())
+        return {};
+
+    return iter->second->create();
+}
+
+bool CodecRegistry::contains(int payloadType) const
+{
+    return mFactories.count(payloadType) > 0;
+}
+
+const CodecList::Settings& CodecRegistry::settings() const
+{
+    return mList.settings();
+}
+
+// ----------------------------------------
+
 CodecListPriority::CodecListPriority()
 {}
 
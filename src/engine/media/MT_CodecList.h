@@ -14,6 +14,8 @@
 #include <vector>
 #include <set>
 #include <list>
+#include <map>
+#include <mutex>
 #include "../helper/HL_VariantMap.h"
 
 #define ALL_CODECS_STRING "OPUS,ISAC,ILBC,PCMU,PCMA,G722,GSM"
@@ -27,6 +29,10 @@ public:
     {
         bool mWrapIuUP              = false;
         bool mSkipDecode            = false;
+        bool mAdaptivePlayout       = false;    // Realtime playout adapts jitter buffer delay by time-stretching decoded audio; opt-in as it changes latency and audio
+        // AudioStream parses RTP itself; jrtplib session gets RTCP only. jrtplib then has no received RTP state,
+        // so outgoing SR/RR carry no report blocks (loss, highest seqno, jitter) - off unless peer feedback is not needed.
+        bool mNativeRtpReceive      = false;
 
         // RFC2833 DTMF
         int mTelephoneEvent = -1;
@@ -125,6 +131,7 @@ public:
     void            fillCodecMap(CodecMap& cm);
     PCodec          createCodecByPayloadType(int payloadType);
     void            clear();
+    const Settings& settings() const { return mSettings; }
 
 protected:
     typedef std::vector<std::shared_ptr<Codec::Factory>> FactoryList;
@@ -134,6 +141,25 @@ protected:
     void init(const Settings& settings);
 };
 
+// Immutable set of codec factories shared by all receivers with the same settings while any of them lives.
+// Receivers share it instead of owning CodecList and create codecs only for payload types they really get.
+class CodecRegistry
+{
+public:
+    static std::shared_ptr<const CodecRegistry> get(const CodecList::Settings& settings);
+
+    // Creates codec for payload type; returns null for unknown one. Thread-safe - factories which keep state guard it themselves.
+    PCodec  create(int payloadType) const;
+    bool    contains(int payloadType) const;
+    const CodecList::Settings& settings() const;
+
+protected:
+    CodecRegistry(const CodecList::Settings& settings);
+
+    CodecList                       mList;
+    std::map<int, Codec::Factory*>  mFactories;     // Payload type -> factory; first factory wins as in CodecList
+};
+
 class CodecListPriority
 {
 public:
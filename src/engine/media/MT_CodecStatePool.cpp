@@ -0,0 +1,158 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "MT_CodecStatePool.h"
+
+#include <sstream>
+
+using namespace MT;
+
+CodecStatePool& CodecStatePool::instance()
+{
+    // Never destroyed - codecs may be released by static destructors of other objects
+    static CodecStatePool* pool = new CodecStatePool();
+    return *pool;
+}
+
+CodecStatePool::CodecStatePool()
+{}
+
+CodecStatePool::Pool& CodecStatePool::poolFor(const StateType& type)
+{
+    for (Pool& p: mPools)
+    {
+        if (p.mType == &type)
+            return p;
+    }
+
+    mPools.push_back({.mType = &type});
+    return mPools.back();
+}
+
+void* CodecStatePool::acquire(const StateType& type, int key)
+{
+    {
+        std::unique_lock<std::mutex> l(mGuard);
+        Pool& p = poolFor(type);
+        p.mAcquired++;
+
+        // Take the most recently released state - it is likely still in cache
+        for (auto iter = p.mIdle.rbegin(); iter != p.mIdle.rend(); ++iter)
+        {
+            if (iter->mKey == key)
+            {
+                void* result = iter->mState;
+                p.mIdle.erase(std::next(iter).base());
+                p.mHits++;
+                return result;
+            }
+        }
+    }
+
+    // Creation may be slow - do it without lock
+    return type.mCreate(key);
+}
+
+void CodecStatePool::release(const StateType& type, void* state, int key)
+{
+    if (!state)
+        return;
+
+    // No reason to reset state which is not kept
+    if (!mCapacity.load(std::memory_order_relaxed))
+    {
+        type.mDestroy(state);
+        return;
+    }
+
+    // Reset here so acquire() gets ready state; it is done without lock as well
+    type.mReset(state, key);
+
+    {
+        std::unique_lock<std::mutex> l(mGuard);
+        Pool& p = poolFor(type);
+        if (p.mIdle.size() < mCapacity.load(std::memory_order_relaxed))
+        {
+            p.mIdle.push_back({.mState = state, .mKey = key});
+            return;
+        }
+    }
+
+    type.mDestroy(state);
+}
+
+void CodecStatePool::clear()
+{
+    std::vector<Pool> pools;
+    {
+        std::unique_lock<std::mutex> l(mGuard);
+        for (Pool& p: mPools)
+        {
+            pools.push_back({.mType = p.mType, .mIdle = std::move(p.mIdle)});
+            p.mIdle.clear();
+        }
+    }
+
+    for (Pool& p: pools)
+        for (Idle& i: p.mIdle)
+            p.mType->mDestroy(i.mState);
+}
+
+void CodecStatePool::setCapacity(size_t capacity)
+{
+    std::vector<Pool> extra;
+    {
+        std::unique_lock<std::mutex> l(mGuard);
+        mCapacity = capacity;
+        for (Pool& p: mPools)
+        {
+            if (p.mIdle.size() <= capacity)
+                continue;
+
+            // Oldest states go first - the same way acquire() prefers recent ones
+            auto last = p.mIdle.begin() + (p.mIdle.size() - capacity);
+            extra.push_back({.mType = p.mType, .mIdle = std::vector<Idle>(p.mIdle.begin(), last)});
+            p.mIdle.erase(p.mIdle.begin(), last);
+        }
+    }
+
+    for (Pool& p: extra)
+        for (Idle& i: p.mIdle)
+            p.mType->mDestroy(i.mState);
+}
+
+size_t CodecStatePool::capacity() const
+{
+    return mCapacity.load(std::memory_order_relaxed);
+}
+
+std::vector<CodecStatePool::TypeStatistics> CodecStatePool::statistics() const
+{
+    std::unique_lock<std::mutex> l(mGuard);
+    std::vector<TypeStatistics> result;
+    for (const Pool& p: mPools)
+        result.push_back({.mName = p.mType->mName, .mAcquired = p.mAcquired, .mHits = p.mHits, .mIdle = p.mIdle.size()});
+    return result;
+}
+
+float CodecStatePool::hitRate() const
+{
+    uint64_t acquired = 0, hits = 0;
+    for (const auto& s: statistics())
+    {
+        acquired += s.mAcquired;
+        hits += s.mHits;
+    }
+    return acquired ? float(hits) / acquired : 0.0f;
+}
+
+std::string CodecStatePool::toString() const
+{
+    std::ostringstream oss;
+    oss << "Codec state pool hit rate: " << hitRate();
+    for (const auto& s: statistics())
+        oss << ", " << s.mName << ": " << s.mAcquired << "/" << s.mHits << " idle " << s.mIdle;
+    return oss.str();
+}
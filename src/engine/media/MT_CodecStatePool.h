@@ -0,0 +1,92 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __MT_CODEC_STATE_POOL_H
+#define __MT_CODEC_STATE_POOL_H
+
+#include "../engine_config.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MT
+{
+// Process-wide pool of codec library states (Opus encoder / decoder contexts).
+// Creating them means big allocations and table setup while streams come and go all the time.
+// Codec returns its state on destruction; state is reset to initial condition there and kept for next codec
+// of the same type - so stream setup takes ready state without any initialization.
+class CodecStatePool
+{
+public:
+    // Kind of pooled state; defined by codec module as static object
+    struct StateType
+    {
+        const char* mName;
+        void* (*mCreate)(int key);              // Returns new state in initial condition
+        void  (*mReset)(void* state, int key);  // Returns used state to initial condition
+        void  (*mDestroy)(void* state);
+    };
+
+    static CodecStatePool& instance();
+
+    // Returns state in initial condition; new one is created if pool has nothing suitable.
+    // key tells apart incompatible states of the same type (i.e. Opus samplerate / channels).
+    void* acquire(const StateType& type, int key = 0);
+
+    // Resets state and keeps it for the next acquire(); state is destroyed if pool is full or disabled
+    void release(const StateType& type, void* state, int key = 0);
+
+    // Destroys all idle states
+    void clear();
+
+    // Number of idle states kept per type; MT_CODEC_STATE_POOL_SIZE by default.
+    // 0 disables pooling - released states are destroyed right away. Extra idle states are destroyed.
+    void setCapacity(size_t capacity);
+    size_t capacity() const;
+
+    struct TypeStatistics
+    {
+        const char* mName = nullptr;
+        uint64_t    mAcquired = 0;          // All acquire() calls
+        uint64_t    mHits = 0;              // acquire() calls served by pooled state
+        size_t      mIdle = 0;              // States ready now
+    };
+    std::vector<TypeStatistics> statistics() const;
+
+    // Share of acquire() calls served by pooled states, [0..1]
+    float hitRate() const;
+
+    std::string toString() const;
+
+protected:
+    CodecStatePool();
+
+    struct Idle
+    {
+        void*   mState = nullptr;
+        int     mKey = 0;
+    };
+
+    struct Pool
+    {
+        const StateType*    mType = nullptr;
+        std::vector<Idle>   mIdle;
+        uint64_t            mAcquired = 0,
+                            mHits = 0;
+    };
+
+    // Number of state types is small - linear search is fine
+    std::vector<Pool>   mPools;
+    mutable std::mutex  mGuard;
+    std::atomic<size_t> mCapacity = MT_CODEC_STATE_POOL_SIZE;
+
+    Pool& poolFor(const StateType& type);
+};
+}
+
+#endif
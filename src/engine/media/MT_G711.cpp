@@ -0,0 +1,451 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "MT_G711.h"
+#include "../helper/HL_Log.h"
+#include "webrtc/g711/g711.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+# define G711_X86
+# include <immintrin.h>
+# if defined(_MSC_VER) && !defined(__clang__)
+#  include <intrin.h>
+#  define G711_TARGET_AVX2
+# else
+#  define G711_TARGET_AVX2 __attribute__((target("avx2")))
+# endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define G711_NEON
+# include <arm_neon.h>
+#endif
+
+#define LOG_SUBSYSTEM "media"
+
+using namespace MT;
+
+// Sign masks applied to segment / quantization bits, see linear_to_alaw() and linear_to_ulaw()
+#define ALAW_POSITIVE_MASK  0xD5
+#define ULAW_POSITIVE_MASK  0xFF
+
+// Encoded value depends only on magnitude >> 4 for A-law and on (magnitude + bias) >> 3 for u-law
+#define ALAW_ENCODE_SIZE    (32768 >> 4)
+#define ULAW_ENCODE_SIZE    (((32767 + ULAW_BIAS) >> 3) + 1)
+
+namespace
+{
+struct Tables
+{
+    uint8_t mALawEncode[ALAW_ENCODE_SIZE];  // Segment and quantization bits, before sign mask
+    uint8_t mULawEncode[ULAW_ENCODE_SIZE];
+    int16_t mALawDecode[256];
+    int16_t mULawDecode[256];
+
+    Tables()
+    {
+        // Built from reference routines so the tables cannot diverge from them
+        for (int i = 0; i < ALAW_ENCODE_SIZE; i++)
+            mALawEncode[i] = linear_to_alaw(i << 4) ^ ALAW_POSITIVE_MASK;
+
+        for (int i = 0; i < ULAW_ENCODE_SIZE; i++)
+        {
+            int linear = (i << 3) - ULAW_BIAS;
+            mULawEncode[i] = linear_to_ulaw(linear < 0 ? 0 : linear) ^ ULAW_POSITIVE_MASK;
+        }
+
+        for (int i = 0; i < 256; i++)
+        {
+            mALawDecode[i] = alaw_to_linear(uint8_t(i));
+            mULawDecode[i] = ulaw_to_linear(uint8_t(i));
+        }
+    }
+};
+
+const Tables& tables()
+{
+    static const Tables result;
+    return result;
+}
+
+// --- Table ---
+void encodeALawTable(const int16_t* input, size_t count, uint8_t* output)
+{
+    const Tables& t = tables();
+    for (size_t i = 0; i < count; i++)
+    {
+        int16_t sign = input[i] >> 15;
+        uint16_t magnitude = uint16_t(input[i] ^ sign);
+        output[i] = t.mALawEncode[magnitude >> 4] ^ (sign ? ALAW_AMI_MASK : ALAW_POSITIVE_MASK);
+    }
+}
+
+void encodeULawTable(const int16_t* input, size_t count, uint8_t* output)
+{
+    const Tables& t = tables();
+    for (size_t i = 0; i < count; i++)
+    {
+        int16_t sign = input[i] >> 15;
+        uint16_t magnitude = uint16_t(input[i] ^ sign);
+        output[i] = t.mULawEncode[(magnitude + ULAW_BIAS) >> 3] ^ (sign ? 0x7F : ULAW_POSITIVE_MASK);
+    }
+}
+
+void decodeALawTable(const uint8_t* input, size_t count, int16_t* output)
+{
+    const Tables& t = tables();
+    for (size_t i = 0; i < count; i++)
+        output[i] = t.mALawDecode[input[i]];
+}
+
+void decodeULawTable(const uint8_t* input, size_t count, int16_t* output)
+{
+    const Tables& t = tables();
+    for (size_t i = 0; i < count; i++)
+        output[i] = t.mULawDecode[input[i]];
+}
+
+const G711::Kernels TableKernels = {"table", encodeALawTable, encodeULawTable, decodeALawTable, decodeULawTable};
+
+#if defined(G711_X86)
+// --- SSE2 ---
+// Segment is counted by comparisons against segment bounds. Variable right shift of quantization bits
+// is done by unsigned high multiply with power of two which is halved on every passed bound.
+inline __m128i aLawSse2(__m128i x)
+{
+    __m128i sign = _mm_srai_epi16(x, 15);
+    __m128i magnitude = _mm_xor_si128(x, sign);
+
+    __m128i seg = _mm_cmpgt_epi16(magnitude, _mm_set1_epi16(0xFF));
+    __m128i mult = _mm_set1_epi16(1 << 12);
+    for (int bit = 9; bit <= 14; bit++)
+    {
+        __m128i passed = _mm_cmpgt_epi16(magnitude, _mm_set1_epi16((1 << bit) - 1));
+        seg = _mm_add_epi16(seg, passed);
+        mult = _mm_sub_epi16(mult, _mm_and_si128(_mm_srli_epi16(mult, 1), passed));
+    }
+    seg = _mm_sub_epi16(_mm_setzero_si128(), seg);
+
+    __m128i code = _mm_or_si128(_mm_slli_epi16(seg, 4), _mm_and_si128(_mm_mulhi_epu16(magnitude, mult), _mm_set1_epi16(0x0F)));
+    __m128i mask = _mm_xor_si128(_mm_set1_epi16(ALAW_POSITIVE_MASK), _mm_and_si128(sign, _mm_set1_epi16(0x80)));
+    return _mm_xor_si128(code, mask);
+}
+
+inline __m128i uLawSse2(__m128i x)
+{
+    __m128i sign = _mm_srai_epi16(x, 15);
+    __m128i magnitude = _mm_xor_si128(x, sign);
+    __m128i biased = _mm_add_epi16(magnitude, _mm_set1_epi16(ULAW_BIAS));    // Up to 32899 - unsigned
+
+    // Bounds are compared on unbiased magnitude to stay in signed range
+    __m128i seg = _mm_setzero_si128();
+    __m128i mult = _mm_set1_epi16(1 << 13);
+    for (int bit = 8; bit <= 15; bit++)
+    {
+        __m128i passed = _mm_cmpgt_epi16(magnitude, _mm_set1_epi16((1 << bit) - ULAW_BIAS - 1));
+        seg = _mm_sub_epi16(seg, passed);
+        mult = _mm_sub_epi16(mult, _mm_and_si128(_mm_srli_epi16(mult, 1), passed));
+    }
+
+    // Segment 8 is out of range and is clamped to maximal code
+    __m128i code = _mm_or_si128(_mm_slli_epi16(seg, 4), _mm_and_si128(_mm_mulhi_epu16(biased, mult), _mm_set1_epi16(0x0F)));
+    code = _mm_min_epi16(code, _mm_set1_epi16(0x7F));
+    __m128i mask = _mm_xor_si128(_mm_set1_epi16(ULAW_POSITIVE_MASK), _mm_and_si128(sign, _mm_set1_epi16(0x80)));
+    return _mm_xor_si128(code, mask);
+}
+
+void encodeALawSse2(const int16_t* input, size_t count, uint8_t* output)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = aLawSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i))),
+                b = aLawSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(a, b));
+    }
+    encodeALawTable(input + i, count - i, output + i);
+}
+
+void encodeULawSse2(const int16_t* input, size_t count, uint8_t* output)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = uLawSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i))),
+                b = uLawSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(a, b));
+    }
+    encodeULawTable(input + i, count - i, output + i);
+}
+
+// SSE2 has no byte shuffle to compute decoded value - decoding stays table driven, it is a single load per sample
+const G711::Kernels Sse2Kernels = {"sse2", encodeALawSse2, encodeULawSse2, decodeALawTable, decodeULawTable};
+
+// --- AVX2 ---
+G711_TARGET_AVX2 inline __m256i aLawAvx2(__m256i x)
+{
+    __m256i sign = _mm256_srai_epi16(x, 15);
+    __m256i magnitude = _mm256_xor_si256(x, sign);
+
+    __m256i seg = _mm256_cmpgt_epi16(magnitude, _mm256_set1_epi16(0xFF));
+    __m256i mult = _mm256_set1_epi16(1 << 12);
+    for (int bit = 9; bit <= 14; bit++)
+    {
+        __m256i passed = _mm256_cmpgt_epi16(magnitude, _mm256_set1_epi16((1 << bit) - 1));
+        seg = _mm256_add_epi16(seg, passed);
+        mult = _mm256_sub_epi16(mult, _mm256_and_si256(_mm256_srli_epi16(mult, 1), passed));
+    }
+    seg = _mm256_sub_epi16(_mm256_setzero_si256(), seg);
+
+    __m256i code = _mm256_or_si256(_mm256_slli_epi16(seg, 4), _mm256_and_si256(_mm256_mulhi_epu16(magnitude, mult), _mm256_set1_epi16(0x0F)));
+    __m256i mask = _mm256_xor_si256(_mm256_set1_epi16(ALAW_POSITIVE_MASK), _mm256_and_si256(sign, _mm256_set1_epi16(0x80)));
+    return _mm256_xor_si256(code, mask);
+}
+
+G711_TARGET_AVX2 inline __m256i uLawAvx2(__m256i x)
+{
+    __m256i sign = _mm256_srai_epi16(x, 15);
+    __m256i magnitude = _mm256_xor_si256(x, sign);
+    __m256i biased = _mm256_add_epi16(magnitude, _mm256_set1_epi16(ULAW_BIAS));
+
+    __m256i seg = _mm256_setzero_si256();
+    __m256i mult = _mm256_set1_epi16(1 << 13);
+    for (int bit = 8; bit <= 15; bit++)
+    {
+        __m256i passed = _mm256_cmpgt_epi16(magnitude, _mm256_set1_epi16((1 << bit) - ULAW_BIAS - 1));
+        seg = _mm256_sub_epi16(seg, passed);
+        mult = _mm256_sub_epi16(mult, _mm256_and_si256(_mm256_srli_epi16(mult, 1), passed));
+    }
+
+    __m256i code = _mm256_or_si256(_mm256_slli_epi16(seg, 4), _mm256_and_si256(_mm256_mulhi_epu16(biased, mult), _mm256_set1_epi16(0x0F)));
+    code = _mm256_min_epi16(code, _mm256_set1_epi16(0x7F));
+    __m256i mask = _mm256_xor_si256(_mm256_set1_epi16(ULAW_POSITIVE_MASK), _mm256_and_si256(sign, _mm256_set1_epi16(0x80)));
+    return _mm256_xor_si256(code, mask);
+}
+
+// Packs two vectors of codes into 32 bytes keeping sample order (packus works per 128-bit lane)
+G711_TARGET_AVX2 inline void storeCodesAvx2(uint8_t* output, __m256i a, __m256i b)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+}
+
+G711_TARGET_AVX2 void encodeALawAvx2(const int16_t* input, size_t count, uint8_t* output)
+{
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+        storeCodesAvx2(output + i, aLawAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i))),
+                                   aLawAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i + 16))));
+    encodeALawTable(input + i, count - i, output + i);
+}
+
+G711_TARGET_AVX2 void encodeULawAvx2(const int16_t* input, size_t count, uint8_t* output)
+{
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+        storeCodesAvx2(output + i, uLawAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i))),
+                                   uLawAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i + 16))));
+    encodeULawTable(input + i, count - i, output + i);
+}
+
+// Decoding shifts quantization bits by segment; the power of two comes from byte shuffle
+G711_TARGET_AVX2 void decodeALawAvx2(const uint8_t* input, size_t count, int16_t* output)
+{
+    const __m256i powers = _mm256_setr_epi8(1, 1, 2, 4, 8, 16, 32, 64, 0, 0, 0, 0, 0, 0, 0, 0,
+                                            1, 1, 2, 4, 8, 16, 32, 64, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i a = _mm256_xor_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i))), _mm256_set1_epi16(ALAW_AMI_MASK));
+        __m256i seg = _mm256_srli_epi16(_mm256_and_si256(a, _mm256_set1_epi16(0x70)), 4);
+        __m256i quant = _mm256_slli_epi16(_mm256_and_si256(a, _mm256_set1_epi16(0x0F)), 4);
+
+        // Segment 0: quant + 8; others: (quant + 0x108) << (seg - 1)
+        __m256i hasSeg = _mm256_cmpgt_epi16(seg, _mm256_setzero_si256());
+        __m256i base = _mm256_add_epi16(quant, _mm256_blendv_epi8(_mm256_set1_epi16(8), _mm256_set1_epi16(0x108), hasSeg));
+        __m256i mult = _mm256_shuffle_epi8(powers, _mm256_or_si256(seg, _mm256_set1_epi16((short)0x8000)));
+        __m256i value = _mm256_mullo_epi16(base, mult);
+
+        // Sign bit set means positive value
+        __m256i negative = _mm256_cmpeq_epi16(_mm256_and_si256(a, _mm256_set1_epi16(0x80)), _mm256_setzero_si256());
+        value = _mm256_sub_epi16(_mm256_xor_si256(value, negative), negative);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), value);
+    }
+    decodeALawTable(input + i, count - i, output + i);
+}
+
+G711_TARGET_AVX2 void decodeULawAvx2(const uint8_t* input, size_t count, int16_t* output)
+{
+    const __m256i powers = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0,
+                                            1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i u = _mm256_xor_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i))), _mm256_set1_epi16(0xFF));
+        __m256i seg = _mm256_srli_epi16(_mm256_and_si256(u, _mm256_set1_epi16(0x70)), 4);
+        __m256i base = _mm256_add_epi16(_mm256_slli_epi16(_mm256_and_si256(u, _mm256_set1_epi16(0x0F)), 3), _mm256_set1_epi16(ULAW_BIAS));
+        __m256i mult = _mm256_shuffle_epi8(powers, _mm256_or_si256(seg, _mm256_set1_epi16((short)0x8000)));
+        __m256i value = _mm256_sub_epi16(_mm256_mullo_epi16(base, mult), _mm256_set1_epi16(ULAW_BIAS));
+
+        __m256i negative = _mm256_cmpeq_epi16(_mm256_and_si256(u, _mm256_set1_epi16(0x80)), _mm256_set1_epi16(0x80));
+        value = _mm256_sub_epi16(_mm256_xor_si256(value, negative), negative);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), value);
+    }
+    decodeULawTable(input + i, count - i, output + i);
+}
+
+const G711::Kernels Avx2Kernels = {"avx2", encodeALawAvx2, encodeULawAvx2, decodeALawAvx2, decodeULawAvx2};
+
+bool hasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // AVX2 registers must be enabled by OS as well
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#if defined(G711_NEON)
+// --- NEON ---
+// NEON has leading zero count and per-lane shifts, so the reference formulas map directly
+inline uint8x8_t aLawNeon(int16x8_t x)
+{
+    int16x8_t sign = vshrq_n_s16(x, 15);
+    uint16x8_t magnitude = vreinterpretq_u16_s16(veorq_s16(x, sign));
+
+    // seg = top_bit(magnitude | 0xFF) - 7; quantization bits are shifted by seg + 3, but at least by 4
+    int16x8_t seg = vsubq_s16(vdupq_n_s16(8), vreinterpretq_s16_u16(vclzq_u16(vorrq_u16(magnitude, vdupq_n_u16(0xFF)))));
+    int16x8_t shift = vaddq_s16(vmaxq_s16(seg, vdupq_n_s16(1)), vdupq_n_s16(3));
+    uint16x8_t quant = vandq_u16(vshlq_u16(magnitude, vnegq_s16(shift)), vdupq_n_u16(0x0F));
+
+    uint16x8_t code = vorrq_u16(vshlq_n_u16(vreinterpretq_u16_s16(seg), 4), quant);
+    uint16x8_t mask = veorq_u16(vdupq_n_u16(ALAW_POSITIVE_MASK), vandq_u16(vreinterpretq_u16_s16(sign), vdupq_n_u16(0x80)));
+    return vmovn_u16(veorq_u16(code, mask));
+}
+
+inline uint8x8_t uLawNeon(int16x8_t x)
+{
+    int16x8_t sign = vshrq_n_s16(x, 15);
+    uint16x8_t biased = vaddq_u16(vreinterpretq_u16_s16(veorq_s16(x, sign)), vdupq_n_u16(ULAW_BIAS));
+
+    int16x8_t seg = vsubq_s16(vdupq_n_s16(8), vreinterpretq_s16_u16(vclzq_u16(vorrq_u16(biased, vdupq_n_u16(0xFF)))));
+    int16x8_t shift = vaddq_s16(seg, vdupq_n_s16(3));
+    uint16x8_t quant = vandq_u16(vshlq_u16(biased, vnegq_s16(shift)), vdupq_n_u16(0x0F));
+
+    uint16x8_t code = vminq_u16(vorrq_u16(vshlq_n_u16(vreinterpretq_u16_s16(seg), 4), quant), vdupq_n_u16(0x7F));
+    uint16x8_t mask = veorq_u16(vdupq_n_u16(ULAW_POSITIVE_MASK), vandq_u16(vreinterpretq_u16_s16(sign), vdupq_n_u16(0x80)));
+    return vmovn_u16(veorq_u16(code, mask));
+}
+
+void encodeALawNeon(const int16_t* input, size_t count, uint8_t* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        vst1_u8(output + i, aLawNeon(vld1q_s16(input + i)));
+    encodeALawTable(input + i, count - i, output + i);
+}
+
+void encodeULawNeon(const int16_t* input, size_t count, uint8_t* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        vst1_u8(output + i, uLawNeon(vld1q_s16(input + i)));
+    encodeULawTable(input + i, count - i, output + i);
+}
+
+void decodeALawNeon(const uint8_t* input, size_t count, int16_t* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t a = veorq_u16(vmovl_u8(vld1_u8(input + i)), vdupq_n_u16(ALAW_AMI_MASK));
+        uint16x8_t seg = vshrq_n_u16(vandq_u16(a, vdupq_n_u16(0x70)), 4);
+        uint16x8_t quant = vshlq_n_u16(vandq_u16(a, vdupq_n_u16(0x0F)), 4);
+
+        // Segment 0: quant + 8; others: (quant + 0x108) << (seg - 1)
+        uint16x8_t hasSeg = vcgtq_u16(seg, vdupq_n_u16(0));
+        uint16x8_t base = vaddq_u16(quant, vbslq_u16(hasSeg, vdupq_n_u16(0x108), vdupq_n_u16(8)));
+        int16x8_t value = vreinterpretq_s16_u16(vshlq_u16(base, vreinterpretq_s16_u16(vqsubq_u16(seg, vdupq_n_u16(1)))));
+
+        uint16x8_t positive = vtstq_u16(a, vdupq_n_u16(0x80));
+        vst1q_s16(output + i, vbslq_s16(positive, value, vnegq_s16(value)));
+    }
+    decodeALawTable(input + i, count - i, output + i);
+}
+
+void decodeULawNeon(const uint8_t* input, size_t count, int16_t* output)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t u = veorq_u16(vmovl_u8(vld1_u8(input + i)), vdupq_n_u16(0xFF));
+        int16x8_t seg = vreinterpretq_s16_u16(vshrq_n_u16(vandq_u16(u, vdupq_n_u16(0x70)), 4));
+        uint16x8_t base = vaddq_u16(vshlq_n_u16(vandq_u16(u, vdupq_n_u16(0x0F)), 3), vdupq_n_u16(ULAW_BIAS));
+        int16x8_t value = vsubq_s16(vreinterpretq_s16_u16(vshlq_u16(base, seg)), vdupq_n_s16(ULAW_BIAS));
+
+        uint16x8_t negative = vtstq_u16(u, vdupq_n_u16(0x80));
+        vst1q_s16(output + i, vbslq_s16(negative, vnegq_s16(value), value));
+    }
+    decodeULawTable(input + i, count - i, output + i);
+}
+
+const G711::Kernels NeonKernels = {"neon", encodeALawNeon, encodeULawNeon, decodeALawNeon, decodeULawNeon};
+#endif
+
+const G711::Kernels& detect()
+{
+    const G711::Kernels* result = &TableKernels;
+#if defined(G711_NEON)
+    result = &NeonKernels;
+#endif
+#if defined(G711_X86)
+    result = hasAvx2() ? &Avx2Kernels : &Sse2Kernels;
+#endif
+    ICELogInfo(<< "G.711 kernels: " << result->mName);
+    return *result;
+}
+}
+
+const G711::Kernels* G711::kernels(Variant variant)
+{
+    switch (variant)
+    {
+    case Variant::Table:
+        return &TableKernels;
+
+#if defined(G711_X86)
+    case Variant::Sse2:
+        return &Sse2Kernels;
+
+    case Variant::Avx2:
+        return hasAvx2() ? &Avx2Kernels : nullptr;
+#endif
+
+#if defined(G711_NEON)
+    case Variant::Neon:
+        return &NeonKernels;
+#endif
+
+    default:
+        return nullptr;
+    }
+}
+
+const G711::Kernels& G711::best()
+{
+    static const Kernels& result = detect();
+    return result;
+}
@@ -0,0 +1,48 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef __MT_G711_H
+#define __MT_G711_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MT
+{
+// G.711 companding kernels. Every variant is bit-exact with webrtc G.711 routines (libs/webrtc/g711).
+// Table variant runs anywhere; vector variants are chosen at runtime when CPU supports them.
+namespace G711
+{
+    struct Kernels
+    {
+        const char* mName;
+        void (*mEncodeALaw)(const int16_t* input, size_t count, uint8_t* output);
+        void (*mEncodeULaw)(const int16_t* input, size_t count, uint8_t* output);
+        void (*mDecodeALaw)(const uint8_t* input, size_t count, int16_t* output);
+        void (*mDecodeULaw)(const uint8_t* input, size_t count, int16_t* output);
+    };
+
+    enum class Variant
+    {
+        Table,
+        Sse2,
+        Avx2,
+        Neon
+    };
+
+    // Returns kernels of given variant; nullptr if build or CPU does not support it
+    const Kernels* kernels(Variant variant);
+
+    // Fastest supported kernels; detected once
+    const Kernels& best();
+
+    inline void encodeALaw(const int16_t* input, size_t count, uint8_t* output)   { best().mEncodeALaw(input, count, output); }
+    inline void encodeULaw(const int16_t* input, size_t count, uint8_t* output)   { best().mEncodeULaw(input, count, output); }
+    inline void decodeALaw(const uint8_t* input, size_t count, int16_t* output)   { best().mDecodeALaw(input, count, output); }
+    inline void decodeULaw(const uint8_t* input, size_t count, int16_t* output)   { best().mDecodeULaw(input, count, output); }
+}
+}
+
+#endif
@@ -10,8 +10,8 @@
 #define LOG_SUBSYSTEM "media"
 using namespace MT;
 
-NativeRtpSender::NativeRtpSender(Statistics& stat)
-    :mStat(stat), mSrtpSession(nullptr)
+NativeRtpSender::NativeRtpSender(Statistics& stat, Mutex& statGuard)
+    :mStat(stat), mStatGuard(statGuard), mSrtpSession(nullptr)
 {
 }
 
@@ -29,22 +29,30 @@ bool NativeRtpSender::SendRTP(const void *data, size_t len)
         mDumpWriter->add(data, len);
 #endif
 
-    // Copy data to intermediary buffer bigger that original
+    // Copy data to intermediary buffer bigger that original.
+    // During media tick the buffer is slot of tick send queue - packet goes out with the rest of tick output.
+    DatagramSendQueue* queue = DatagramSendQueue::active();
+    char* sendBuffer = queue ? reinterpret_cast<char*>(queue->prepare()) : mSendBuffer;
     int sendLength = len;
-    memcpy(mSendBuffer, data, len);
+    memcpy(sendBuffer, data, len);
 
     // Encrypt SRTP if needed
     if (mSrtpSession)
     {
         if (mSrtpSession->active())
         {
-            if (!mSrtpSession->protectRtp(mSendBuffer, &sendLength))
+            if (!mSrtpSession->protectRtp(sendBuffer, &sendLength))
                 return false;
         }
     }
 
     ICELogMedia(<< "Sending " << sendLength <<" bytes to " << mTarget.mRtp.toBriefStdString());
-    mSocket.mRtp->sendDatagram(mTarget.mRtp, mSendBuffer, sendLength);
+    if (queue)
+        queue->commit(mSocket.mRtp, mTarget.mRtp, sendLength);
+    else
+        mSocket.mRtp->sendDatagram(mTarget.mRtp, mSendBuffer, sendLength);
+
+    Lock l(mStatGuard);
     mStat.mSentRtp++;
     mStat.mSent += len;
     auto& perDst = mStat.mPerDestination[mTarget.mRtp];
@@ -60,20 +68,27 @@ bool NativeRtpSender::SendRTCP(const void *data, size_t len)
     if (mTarget.mRtp.isEmpty() || !mSocket.mRtcp)
         return false;
     // Copy data to intermediary buffer bigger that original
+    DatagramSendQueue* queue = DatagramSendQueue::active();
+    char* sendBuffer = queue ? reinterpret_cast<char*>(queue->prepare()) : mSendBuffer;
     int sendLength = len;
-    memcpy(mSendBuffer, data, len);
+    memcpy(sendBuffer, data, len);
 
     // Encrypt SRTP if needed
     if (mSrtpSession)
     {
         if (mSrtpSession->active())
         {
-            if (!mSrtpSession->protectRtcp(mSendBuffer, &sendLength))
+            if (!mSrtpSession->protectRtcp(sendBuffer, &sendLength))
                 return false;
         }
     }
 
-    mSocket.mRtcp->sendDatagram(mTarget.mRtcp, mSendBuffer, sendLength);
+    if (queue)
+        queue->commit(mSocket.mRtcp, mTarget.mRtcp, sendLength);
+    else
+        mSocket.mRtcp->sendDatagram(mTarget.mRtcp, mSendBuffer, sendLength);
+
+    Lock l(mStatGuard);
     mStat.mSentRtcp++;
     mStat.mSent += len;
     auto& perDst = mStat.mPerDestination[mTarget.mRtcp];
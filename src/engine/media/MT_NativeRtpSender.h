@@ -13,6 +13,7 @@
 #include "../helper/HL_InternetAddress.h"
 #include "../helper/HL_Rtp.h"
 #include "../helper/HL_SocketHeap.h"
+#include "../helper/HL_Sync.h"
 #include "MT_Stream.h"
 #include "MT_SrtpHelper.h"
 
@@ -21,7 +22,8 @@ namespace MT
 class NativeRtpSender: public jrtplib::RTPExternalSender
 {
 public:
-    NativeRtpSender(Statistics& stat);
+    // Sent counters go to stat under statGuard - sender runs on mic thread while stream reads them from others
+    NativeRtpSender(Statistics& stat, Mutex& statGuard);
     ~NativeRtpSender();
     
     /** This member function will be called when RTP data needs to be transmitted. */
@@ -50,6 +52,7 @@ protected:
     RtpPair<PDatagramSocket> mSocket;
     RtpPair<InternetAddress> mTarget;
     Statistics& mStat;
+    Mutex& mStatGuard;
 #if defined(USE_RTPDUMP)
     RtpDump* mDumpWriter = nullptr;
 #endif
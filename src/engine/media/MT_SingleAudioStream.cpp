@@ -29,6 +29,11 @@ void SingleAudioStream::process(const std::shared_ptr<jrtplib::RTPPacket>& packe
         mReceiver.add(packet);
 }
 
+int SingleAudioStream::getSize() const
+{
+    return sizeof(*this) - sizeof(mReceiver) + mReceiver.getSize();
+}
+
 void SingleAudioStream::copyPcmTo(Audio::DataWindow& output, int needed)
 {
     // Packet by packet
@@ -20,6 +20,7 @@ public:
     ~SingleAudioStream();
     void process(const std::shared_ptr<jrtplib::RTPPacket>& packet);
     void copyPcmTo(Audio::DataWindow& output, int needed);
+    int getSize() const;
 
 protected:
     DtmfReceiver mDtmfReceiver;
@@ -63,6 +63,7 @@ public:
     /* bufferPtr is RTP packet data i.e. header + payload. Buffer must be big enough to hold encrypted data. */
     bool protectRtp(void* buffer, int* length);
     bool protectRtcp(void* buffer, int* length);
+    // src and dst may point to the same buffer - packet is decrypted in place then
     bool unprotectRtp(const void* src, size_t srcLength, void* dst, size_t* dstLength);
     bool unprotectRtcp(const void* src, size_t srcLength, void* dst, size_t* dstLength);
 
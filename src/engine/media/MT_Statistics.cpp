@@ -258,6 +258,23 @@ double Statistics::calculateMos() const
     return mos;
 }
 
+void Statistics::processQueueDelay(float milliseconds)
+{
+    static const int Buckets[] = {1, 2, 5, 10, 20, 50, 100, 200, 500};
+
+    mQueueDelay.process(milliseconds);
+    int bucket = 1000;
+    for (int b: Buckets)
+    {
+        if (milliseconds < b)
+        {
+            bucket = b;
+            break;
+        }
+    }
+    mQueueDelayHistogram[bucket]++;
+}
+
 Statistics& Statistics::operator += (const Statistics& src)
 {
     mReceived       += src.mReceived;
@@ -270,6 +287,8 @@ Statistics& Statistics::operator += (const Statistics& src)
     mOldRtp         += src.mOldRtp;
     mPacketLoss     += src.mPacketLoss;
     mPacketDropped  += src.mPacketDropped;
+    mLocalDrops     += src.mLocalDrops;
+    mFecRecovered   += src.mFecRecovered;
     mAudioTime      += src.mAudioTime;
 
 
@@ -281,8 +300,17 @@ Statistics& Statistics::operator += (const Statistics& src)
             mCodecCount[codecStat.first] += codecStat.second;
     }
 
+    for (const auto& [bucket, counter]: src.mQueueDelayHistogram)
+        mQueueDelayHistogram[bucket] += counter;
+
     mJitter             = src.mJitter;
     mRttDelay           = src.mRttDelay;
+    mQueueDelay         = src.mQueueDelay;
+    mPlayoutDelay       = src.mPlayoutDelay;
+    mAccelerateCount    += src.mAccelerateCount;
+    mExpandCount        += src.mExpandCount;
+    mAcceleratedTime    += src.mAcceleratedTime;
+    mExpandedTime       += src.mExpandedTime;
     mDecodingInterval   = src.mDecodingInterval;
     mDecodeRequested    = src.mDecodeRequested;
 
@@ -333,6 +361,12 @@ Statistics& Statistics::operator -= (const Statistics& src)
     mOldRtp             -= src.mOldRtp;
     mPacketLoss         -= src.mPacketLoss;
     mPacketDropped      -= src.mPacketDropped;
+    mLocalDrops         -= src.mLocalDrops;
+    mFecRecovered       -= src.mFecRecovered;
+    mAccelerateCount    -= src.mAccelerateCount;
+    mExpandCount        -= src.mExpandCount;
+    mAcceleratedTime    -= src.mAcceleratedTime;
+    mExpandedTime       -= src.mExpandedTime;
     mAudioTime          -= src.mAudioTime;
 
     for (auto codecStat: src.mCodecCount)
@@ -341,6 +375,13 @@ Statistics& Statistics::operator -= (const Statistics& src)
             mCodecCount[codecStat.first] -= codecStat.second;
     }
 
+    for (const auto& [bucket, counter]: src.mQueueDelayHistogram)
+    {
+        auto it = mQueueDelayHistogram.find(bucket);
+        if (it != mQueueDelayHistogram.end())
+            it->second -= counter;
+    }
+
     for (const auto& [addr, counts]: src.mPerDestination)
     {
         auto it = mPerDestination.find(addr);
@@ -364,10 +405,27 @@ std::string Statistics::toString() const
     oss << "Received: "             << mReceivedRtp
         << ", lost: "               << mPacketLoss
         << ", dropped: "            << mPacketDropped
+        << ", local drops: "        << mLocalDrops
+        << ", fec recovered: "      << mFecRecovered
         << ", sent: "               << mSentRtp
         << ", decoding interval: "  << mDecodingInterval.average()
         << ", decode requested: "   << mDecodeRequested.average()
-        << ", packet interval: "    << mPacketInterval.average();
+        << ", packet interval: "    << mPacketInterval.average()
+        << ", queue delay: "        << mQueueDelay.average() << "/" << mQueueDelay.mMax;
+
+    if (!mQueueDelayHistogram.empty())
+    {
+        oss << ", queue delay histogram:";
+        for (const auto& [bucket, counter]: mQueueDelayHistogram)
+            oss << " <" << bucket << "ms=" << counter;
+    }
+
+    if (mPlayoutDelay.is_initialized())
+    {
+        oss << ", playout delay: " << mPlayoutDelay.average() << "/" << mPlayoutDelay.mMax
+            << ", accelerated: " << mAccelerateCount << " (" << mAcceleratedTime.count() << "ms)"
+            << ", expanded: " << mExpandCount << " (" << mExpandedTime.count() << "ms)";
+    }
 
     for (const auto& [addr, counts]: mPerDestination)
     {
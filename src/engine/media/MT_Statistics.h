@@ -99,6 +99,8 @@ public:
                                     mOldRtp = 0,          // Number of late rtp packets
                                     mPacketLoss = 0,      // Number of lost packets
                                     mPacketDropped = 0,   // Number of dropped packets (due to time unsync when playing)б
+                                    mLocalDrops = 0,      // Number of packets dropped by kernel on local socket (receive queue overflow); not in mPacketLoss
+                                    mFecRecovered = 0,    // Number of lost packets recovered from in-band FEC of the next packet; still counted in mPacketLoss
                                     mIllegalRtp = 0;      // Number of rtp packets with bad payload type
 
     // Per-remote-address breakdown of the totals above. Keyed by the remote
@@ -110,6 +112,19 @@ public:
                                     mPacketInterval;        // Average interval between packet adding to jitter buffer
 
     std::map<int,int>               mLoss;                  // Every item is number of loss of corresping length
+
+    // Delay between kernel receive timestamp and processing of datagram (socket queue + reactor), milliseconds.
+    // Histogram key is upper bound of bucket in milliseconds.
+    TestResult<float>               mQueueDelay;
+    std::map<int,int>               mQueueDelayHistogram;
+
+    // Adaptive playout: target delay estimated from packet arrival (milliseconds) and time-stretch decisions.
+    // Accelerated time is latency removed without dropping packets; expanded time is latency added to avoid underrun.
+    TestResult<float>               mPlayoutDelay;
+    size_t                          mAccelerateCount = 0,
+                                    mExpandCount = 0;
+    std::chrono::milliseconds       mAcceleratedTime = 0ms,
+                                    mExpandedTime = 0ms;
     std::chrono::milliseconds       mAudioTime = 0ms;       // Decoded/found time in milliseconds
     size_t                          mDecodedSize = 0;       // Number of decoded bytes
     uint32_t                        mSsrc = 0;              // Last known SSRC ID in a RTP stream
@@ -130,6 +145,8 @@ public:
     std::vector<PacketLossEvent>    mPacketLossTimeline;   // Packet loss timeline
     std::vector<Dtmf2833Event>      mDtmf2833Timeline;
 
+    void processQueueDelay(float milliseconds);
+
     // It is to calculate network MOS
     void calculateBurstr(double* burstr, double* loss) const;
     double calculateMos() const;
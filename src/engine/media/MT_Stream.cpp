@@ -52,7 +52,7 @@ RtpPair<PDatagramSocket>& Stream::socket()
   return mSocket;
 }
 
-Statistics& Stream::statistics()
+Statistics Stream::statistics()
 {
   return mStat;
 }
@@ -53,7 +53,8 @@ namespace MT
     virtual void setDestination(const RtpPair<InternetAddress>& dest);
 
     virtual void setTransmittingCodec(Codec::Factory& factory, int payloadType) = 0;
-    virtual void dataArrived(PDatagramSocket s, const void* buffer, int length, InternetAddress& source) = 0;
+    // receiveTime is kernel receive timestamp of datagram (or the time it was read from socket)
+    virtual void dataArrived(PDatagramSocket s, const void* buffer, int length, InternetAddress& source, DatagramTime receiveTime) = 0;
 
 
     virtual void readFile(const Audio::PWavFileReader& reader, MediaDirection direction) = 0;
@@ -66,7 +67,8 @@ namespace MT
     virtual void setSocket(const RtpPair<PDatagramSocket>& socket);
     virtual RtpPair<PDatagramSocket>& socket();
 
-    Statistics& statistics();
+    // Returns copy of stream statistics; streams updating counters from several threads merge them here
+    virtual Statistics statistics();
     SrtpSession& srtp();
     void configureMediaObserver(MediaObserver* observer, void* userTag);
 
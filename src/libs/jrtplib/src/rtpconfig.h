@@ -66,7 +66,7 @@
 
 #define RTP_SUPPORT_SENDAPP
 
-//${RTP_SUPPORT_MEMORYMANAGEMENT}
+#define RTP_SUPPORT_MEMORYMANAGEMENT
 
 #define RTP_SUPPORT_RTCPUNKNOWN
 
@@ -857,6 +857,11 @@ void RTPExternalTransmitter::InjectRTCP(const void *data, size_t len, const RTPA
 }
 
 void RTPExternalTransmitter::InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a)
+{
+	InjectRTPorRTCP(data, len, a, RTPTime::CurrentTime());
+}
+
+void RTPExternalTransmitter::InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a, const RTPTime &receivetime)
 {
 	if (!init)
 		return;
@@ -890,10 +895,9 @@ void RTPExternalTransmitter::InjectRTPorRTCP(const void *data, size_t len, const
 	}
 	memcpy(datacopy, data, len);
 
-	RTPTime curtime = RTPTime::CurrentTime();
 	RTPRawPacket *pack;
 
-	pack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPRAWPACKET) RTPRawPacket(datacopy,len,addr,curtime,rtp,GetMemoryManager());
+	pack = RTPNew(GetMemoryManager(),RTPMEM_TYPE_CLASS_RTPRAWPACKET) RTPRawPacket(datacopy,len,addr,receivetime,rtp,GetMemoryManager());
 	if (pack == 0)
 	{
 		RTPDelete(addr,GetMemoryManager());
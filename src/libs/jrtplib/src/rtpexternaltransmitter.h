@@ -97,6 +97,9 @@ public:
 	/** Use this function to inject an RTP or RTCP packet and the transmitter will try to figure out which type of packet it is. */
 	void InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a);
 
+	/** Same as above but with known receive time (e.g. kernel timestamp of datagram) instead of current time. */
+	void InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a, const RTPTime &receivetime);
+
     void InjectRaw(RTPRawPacket* packet);
 private:
 	RTPExternalTransmitter *transmitter;
@@ -188,6 +191,7 @@ public:
 	void InjectRTP(const void *data, size_t len, const RTPAddress &a);
 	void InjectRTCP(const void *data, size_t len, const RTPAddress &a);
 	void InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a);
+	void InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a, const RTPTime &receivetime);
     void InjectRaw(RTPRawPacket* packet);
 
 private:
@@ -237,6 +241,11 @@ inline void RTPExternalPacketInjecter::InjectRTPorRTCP(const void *data, size_t
 	transmitter->InjectRTPorRTCP(data, len, a); 
 }
 
+inline void RTPExternalPacketInjecter::InjectRTPorRTCP(const void *data, size_t len, const RTPAddress &a, const RTPTime &receivetime)
+{ 
+	transmitter->InjectRTPorRTCP(data, len, a, receivetime); 
+}
+
 inline void RTPExternalPacketInjecter::InjectRaw(RTPRawPacket* packet)
 {
     transmitter->InjectRaw(packet);
@@ -221,12 +221,12 @@ inline void operator delete[](void *buffer, jrtplib::RTPMemoryManager *mgr, int
 namespace jrtplib
 {
 
-inline void RTPDeleteByteArray(uint8_t *buf, RTPMemoryManager *mgr)
+inline void RTPDeleteByteArray(const uint8_t *buf, RTPMemoryManager *mgr)
 {
 	if (mgr == 0)
 		delete [] buf;
 	else
-		mgr->FreeBuffer(buf);
+		mgr->FreeBuffer(const_cast<uint8_t *>(buf));
 }
 
 template<class ClassName> 
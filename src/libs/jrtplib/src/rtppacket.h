@@ -152,6 +152,7 @@ public:
 	 *  time.
 	 */
 	RTPTime GetReceiveTime() const														{ return receivetime; }
+    void SetReceiveTime(const RTPTime& t)                                               { receivetime = t; }
 private:
 	void Clear();
 	int ParseRawPacket(RTPRawPacket &rawpack);
@@ -0,0 +1,81 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Codec metadata accessors return the same values as info() and make no heap allocations after first use.
+// With --bench compares per-frame metadata lookup through info() with cached accessors.
+
+#include "test_helper.h"
+#include "test_codecs.h"
+
+using namespace MT;
+
+static void testAccessors(const TestCodec& tc)
+{
+    PCodec codec = createTestCodec(tc.mPayloadType);
+    CHECK(codec);
+    if (!codec)
+        return;
+
+    Codec::Info info = codec->info();
+    CHECK(codec->name() == info.mName);
+    CHECK(codec->samplerate() == info.mSamplerate);
+    CHECK(codec->channels() == info.mChannels);
+    CHECK(codec->pcmLength() == info.mPcmLength);
+    CHECK(codec->frameTime() == info.mFrameTime);
+    CHECK(codec->rtpLength() == info.mRtpLength);
+    if (info.mTimestampUnit == 0.0f)
+        CHECK(codec->timestampUnit() == 1.0f / info.mSamplerate);
+    else
+        CHECK(codec->timestampUnit() == info.mTimestampUnit);
+
+    Audio::Format format = codec->getAudioFormat();
+    CHECK(format.mRate == info.mSamplerate);
+    CHECK(format.mChannels == info.mChannels);
+
+    uint64_t before = allocations();
+    int sum = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        sum += codec->pcmLength() + codec->rtpLength() + codec->channels() + codec->samplerate() + codec->frameTime();
+        sum += static_cast<int>(codec->name().size());
+        sum += codec->getAudioFormat().mChannels;
+    }
+    CHECK(allocations() == before);
+    CHECK(sum != 0);
+}
+
+static void benchmark(const TestCodec& tc)
+{
+    PCodec codec = createTestCodec(tc.mPayloadType);
+    if (!codec)
+        return;
+
+    // Fields receiver reads per decoded frame
+    volatile int sink = 0;
+    double infoTime = measure([&]
+    {
+        Codec::Info info = codec->info();
+        sink = info.mPcmLength + info.mSamplerate + info.mChannels + info.mFrameTime;
+    });
+    double cachedTime = measure([&]
+    {
+        sink = codec->pcmLength() + codec->samplerate() + codec->channels() + codec->frameTime();
+    });
+    printf("%-6s metadata per frame: info() %.1f ns, cached accessors %.1f ns\n", tc.mName, infoTime, cachedTime);
+}
+
+int main(int argc, char* argv[])
+{
+    for (const TestCodec& tc: TestCodecs)
+        testAccessors(tc);
+
+    if (benchRequested(argc, argv))
+    {
+        for (const TestCodec& tc: TestCodecs)
+            benchmark(tc);
+    }
+
+    return testResult("codec_info_test");
+}
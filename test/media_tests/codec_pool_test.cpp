@@ -0,0 +1,167 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Codec taking pooled state behaves exactly as codec with freshly created state: Opus decoder and encoder
+// give the same output after state was used by another stream and reset.
+// With --bench compares codec setup of new stream (create, first decode and encode) with and without pooling.
+
+#include "media/MT_CodecStatePool.h"
+#include "media/MT_AudioCodec.h"
+
+#include "test_helper.h"
+#include "test_codecs.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace MT;
+
+static const int Frames = 50;
+
+static const int OpusPayloadType = 106;
+
+struct Output
+{
+    std::vector<uint8_t> mDecoded, mEncoded;
+};
+
+// Decodes payloads and encodes test signal starting from frame 'signalStart'
+static Output run(Codec& codec, const std::vector<std::vector<uint8_t>>& payloads, int signalStart)
+{
+    Output result;
+    std::vector<uint8_t> buffer(std::max(codec.pcmLength() * 4, 4096));
+    for (auto& p: payloads)
+    {
+        auto r = codec.decode(p, buffer);
+        result.mDecoded.insert(result.mDecoded.end(), buffer.begin(), buffer.begin() + r.mDecoded);
+    }
+
+    int frameSamples = codec.pcmLength() / 2 / codec.channels();
+    for (int i = signalStart; i < signalStart + Frames; i++)
+    {
+        auto pcm = testSignal(codec.samplerate(), codec.channels(), i, frameSamples);
+        auto r = codec.encode({reinterpret_cast<const uint8_t*>(pcm.data()), pcm.size() * 2}, buffer);
+        result.mEncoded.insert(result.mEncoded.end(), buffer.begin(), buffer.begin() + r.mEncoded);
+    }
+    return result;
+}
+
+static uint64_t poolHits()
+{
+    uint64_t result = 0;
+    for (auto& s: CodecStatePool::instance().statistics())
+        result += s.mHits;
+    return result;
+}
+
+static void testResetEqualsFresh()
+{
+    // Payloads are made first - their encoder states must not get into the pool used below
+    auto payloads = testPayloads(OpusPayloadType, Frames);
+    CHECK(payloads.size() == Frames);
+    auto other = payloads;
+    std::reverse(other.begin(), other.end());
+
+    CodecStatePool& pool = CodecStatePool::instance();
+    pool.clear();
+
+    Output fresh;
+    {
+        PCodec codec = createTestCodec(OpusPayloadType);
+        fresh = run(*codec, payloads, 0);
+    }
+    CHECK(!fresh.mDecoded.empty());
+    CHECK(!fresh.mEncoded.empty());
+
+    // Another stream takes the states and leaves them in different condition
+    {
+        PCodec codec = createTestCodec(OpusPayloadType);
+        if (auto opus = std::dynamic_pointer_cast<OpusCodec>(codec))
+        {
+            OpusCodec::Params params;
+            params.mUseDtx = true;
+            params.mUseInbandFec = true;
+            params.mTargetBitrate = 12000;
+            params.mExpectedPacketLoss = 30;
+            opus->applyParams(params);
+        }
+        run(*codec, other, 1000);
+    }
+
+    uint64_t hits = poolHits();
+    Output reused;
+    {
+        PCodec codec = createTestCodec(OpusPayloadType);
+        reused = run(*codec, payloads, 0);
+    }
+    CHECK(poolHits() > hits);
+
+    if (reused.mDecoded != fresh.mDecoded)
+        fprintf(stderr, "opus: decoder output differs after reset\n");
+    if (reused.mEncoded != fresh.mEncoded)
+        fprintf(stderr, "opus: encoder output differs after reset\n");
+    CHECK(reused.mDecoded == fresh.mDecoded);
+    CHECK(reused.mEncoded == fresh.mEncoded);
+}
+
+static void benchmark()
+{
+    auto payloads = testPayloads(OpusPayloadType, 1);
+    std::vector<uint8_t> buffer(8192);
+
+    // Receiver codec of new stream: creation and first decoded packet - decoder states are created lazily
+    auto setup = [&]
+    {
+        PCodec codec = createTestCodec(OpusPayloadType);
+        codec->decode(payloads.front(), buffer);
+        std::vector<int16_t> silence(codec->pcmLength() / 2);
+        codec->encode({reinterpret_cast<const uint8_t*>(silence.data()), silence.size() * 2}, buffer);
+    };
+
+    CodecStatePool& pool = CodecStatePool::instance();
+    size_t capacity = pool.capacity();
+
+    pool.setCapacity(0);
+    double unpooled = measure(setup);
+    pool.setCapacity(capacity);
+    setup();
+    double pooled = measure(setup);
+
+    printf("opus   codec setup of new stream: without pool %.1f us, with pool %.1f us\n", unpooled / 1000, pooled / 1000);
+}
+
+static void testCapacity()
+{
+    CodecStatePool& pool = CodecStatePool::instance();
+    size_t capacity = pool.capacity();
+    auto payloads = testPayloads(OpusPayloadType, 1);
+    pool.clear();
+    std::vector<uint8_t> buffer(8192);
+
+    // Disabled pool keeps nothing
+    pool.setCapacity(0);
+    createTestCodec(OpusPayloadType)->decode(payloads.front(), buffer);
+    for (auto& s: pool.statistics())
+        CHECK(s.mIdle == 0);
+
+    // Encoder and decoder states are kept
+    pool.setCapacity(capacity);
+    createTestCodec(OpusPayloadType)->decode(payloads.front(), buffer);
+    size_t idle = 0;
+    for (auto& s: pool.statistics())
+        idle += s.mIdle;
+    CHECK(idle == 2);
+}
+
+int main(int argc, char* argv[])
+{
+    testResetEqualsFresh();
+    testCapacity();
+
+    if (benchRequested(argc, argv))
+        benchmark();
+
+    return testResult("codec_pool_test");
+}
@@ -0,0 +1,157 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Codec::decodeBatch() gives the same PCM and per-input results as decode() called in loop on fresh codec,
+// and stops before input which does not fit into output. Payloads come from the codecs' own encoders
+// (synthetic bandwidth-efficient payloads for AMR).
+// With --bench compares decode cost of 5 consecutive payloads.
+
+#include "test_helper.h"
+#include "test_codecs.h"
+
+#include <vector>
+
+using namespace MT;
+
+static const int Frames = 50;
+
+struct Decoded
+{
+    std::vector<uint8_t>                    mPcm;
+    std::vector<Codec::DecodeResult>        mResults;
+};
+
+static Decoded decodeLoop(int payloadType, const std::vector<std::vector<uint8_t>>& payloads)
+{
+    PCodec codec = createTestCodec(payloadType);
+    Decoded result;
+    std::vector<uint8_t> buffer(codec->pcmLength() * 4);
+    for (auto& p: payloads)
+    {
+        auto r = codec->decode(p, buffer);
+        result.mResults.push_back(r);
+        result.mPcm.insert(result.mPcm.end(), buffer.begin(), buffer.begin() + r.mDecoded);
+    }
+    return result;
+}
+
+// Decodes payloads with batches of up to 'batch' inputs
+static Decoded decodeBatches(int payloadType, const std::vector<std::vector<uint8_t>>& payloads, size_t batch)
+{
+    PCodec codec = createTestCodec(payloadType);
+    Decoded result;
+    std::vector<std::span<const uint8_t>> inputs(payloads.begin(), payloads.end());
+    // AMR payload may carry two frames
+    std::vector<uint8_t> buffer(codec->pcmLength() * batch * 2);
+    std::vector<Codec::DecodeResult> results(batch);
+
+    size_t pos = 0;
+    while (pos < inputs.size())
+    {
+        size_t count = std::min(batch, inputs.size() - pos);
+        size_t done = codec->decodeBatch(std::span(inputs).subspan(pos, count), buffer, results);
+        CHECK(done == count);
+        if (!done)
+            break;
+
+        size_t decoded = 0;
+        for (size_t i = 0; i < done; i++)
+        {
+            result.mResults.push_back(results[i]);
+            decoded += results[i].mDecoded;
+        }
+        result.mPcm.insert(result.mPcm.end(), buffer.begin(), buffer.begin() + decoded);
+        pos += done;
+    }
+    return result;
+}
+
+static void testEquality(const TestCodec& tc)
+{
+    auto payloads = testPayloads(tc.mPayloadType, Frames);
+    CHECK(payloads.size() == Frames);
+    if (payloads.empty())
+        return;
+
+    Decoded expected = decodeLoop(tc.mPayloadType, payloads);
+    CHECK(!expected.mPcm.empty());
+
+    for (size_t batch: {1, 2, 3, 7, 16})
+    {
+        Decoded actual = decodeBatches(tc.mPayloadType, payloads, batch);
+        bool same = actual.mPcm == expected.mPcm && actual.mResults.size() == expected.mResults.size();
+        for (size_t i = 0; same && i < actual.mResults.size(); i++)
+            same = actual.mResults[i].mDecoded == expected.mResults[i].mDecoded && actual.mResults[i].mIsCng == expected.mResults[i].mIsCng;
+        if (!same)
+            fprintf(stderr, "%s: batch of %zu differs from looped decode\n", tc.mName, batch);
+        CHECK(same);
+    }
+}
+
+static void testShortOutput(const TestCodec& tc)
+{
+    auto payloads = testPayloads(tc.mPayloadType, 4);
+    if (payloads.size() != 4)
+        return;
+
+    PCodec codec = createTestCodec(tc.mPayloadType);
+    std::vector<std::span<const uint8_t>> inputs(payloads.begin(), payloads.end());
+    std::vector<Codec::DecodeResult> results(inputs.size());
+
+    // Room for two and a half frames - third input may not fit and is left for the next call
+    std::vector<uint8_t> buffer(codec->pcmLength() * 5 / 2);
+    CHECK(codec->decodeBatch(inputs, buffer, results) == 2);
+
+    // Results are limited by their own size as well
+    std::vector<uint8_t> big(codec->pcmLength() * 4);
+    CHECK(codec->decodeBatch(inputs, big, std::span(results).first(1)) == 1);
+}
+
+static void benchmark(const TestCodec& tc)
+{
+    const size_t batch = 5;
+    auto payloads = testPayloads(tc.mPayloadType, Frames);
+    if (payloads.size() < batch)
+        return;
+
+    PCodec loopCodec = createTestCodec(tc.mPayloadType), batchCodec = createTestCodec(tc.mPayloadType);
+    std::vector<std::span<const uint8_t>> inputs(payloads.begin(), payloads.end());
+    std::vector<uint8_t> buffer(loopCodec->pcmLength() * batch * 2);
+    std::vector<Codec::DecodeResult> results(batch);
+
+    size_t pos = 0;
+    double loopTime = measure([&]
+    {
+        size_t offset = 0;
+        for (size_t i = 0; i < batch; i++)
+            offset += loopCodec->decode(inputs[(pos + i) % inputs.size()], std::span(buffer).subspan(offset)).mDecoded;
+        pos = (pos + batch) % (inputs.size() - batch);
+    });
+
+    pos = 0;
+    double batchTime = measure([&]
+    {
+        batchCodec->decodeBatch(std::span(inputs).subspan(pos, batch), buffer, results);
+        pos = (pos + batch) % (inputs.size() - batch);
+    });
+    printf("%-6s %zu payloads: looped decode %.0f ns, decodeBatch %.0f ns\n", tc.mName, batch, loopTime, batchTime);
+}
+
+int main(int argc, char* argv[])
+{
+    for (const TestCodec& tc: TestCodecs)
+    {
+        testEquality(tc);
+        testShortOutput(tc);
+    }
+
+    if (benchRequested(argc, argv))
+    {
+        for (const TestCodec& tc: TestCodecs)
+            benchmark(tc);
+    }
+
+    return testResult("decode_batch_test");
+}
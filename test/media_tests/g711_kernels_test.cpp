@@ -0,0 +1,183 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Every G.711 kernel variant supported here is bit-exact with webrtc G.711 routines:
+// all 65536 linear inputs are encoded, all 256 codes are decoded, and every length 0..63 is run
+// from unaligned offset so vector main loops and scalar tails are both covered.
+// With --bench reports samples/s per variant and for webrtc routines.
+
+#include "media/MT_G711.h"
+#include "webrtc/g711/g711.h"
+
+#include "test_helper.h"
+
+#include <vector>
+
+using namespace MT;
+
+static const G711::Variant Variants[] = {G711::Variant::Table, G711::Variant::Sse2, G711::Variant::Avx2, G711::Variant::Neon};
+
+static void webrtcEncodeALaw(const int16_t* input, size_t count, uint8_t* output)
+{
+    for (size_t i = 0; i < count; i++)
+        output[i] = linear_to_alaw(input[i]);
+}
+
+static void webrtcEncodeULaw(const int16_t* input, size_t count, uint8_t* output)
+{
+    for (size_t i = 0; i < count; i++)
+        output[i] = linear_to_ulaw(input[i]);
+}
+
+static void webrtcDecodeALaw(const uint8_t* input, size_t count, int16_t* output)
+{
+    for (size_t i = 0; i < count; i++)
+        output[i] = alaw_to_linear(input[i]);
+}
+
+static void webrtcDecodeULaw(const uint8_t* input, size_t count, int16_t* output)
+{
+    for (size_t i = 0; i < count; i++)
+        output[i] = ulaw_to_linear(input[i]);
+}
+
+static const G711::Kernels WebrtcKernels = {"webrtc", webrtcEncodeALaw, webrtcEncodeULaw, webrtcDecodeALaw, webrtcDecodeULaw};
+
+static std::vector<int16_t> allLinear()
+{
+    std::vector<int16_t> result(65536);
+    for (int i = 0; i < 65536; i++)
+        result[i] = static_cast<int16_t>(i - 32768);
+    return result;
+}
+
+static std::vector<uint8_t> allCodes()
+{
+    std::vector<uint8_t> result(256);
+    for (int i = 0; i < 256; i++)
+        result[i] = static_cast<uint8_t>(i);
+    return result;
+}
+
+static void testExhaustive(const G711::Kernels& k)
+{
+    auto linear = allLinear();
+    std::vector<uint8_t> expected(linear.size()), actual(linear.size());
+
+    WebrtcKernels.mEncodeALaw(linear.data(), linear.size(), expected.data());
+    k.mEncodeALaw(linear.data(), linear.size(), actual.data());
+    CHECK(expected == actual);
+
+    WebrtcKernels.mEncodeULaw(linear.data(), linear.size(), expected.data());
+    k.mEncodeULaw(linear.data(), linear.size(), actual.data());
+    CHECK(expected == actual);
+
+    auto codes = allCodes();
+    std::vector<int16_t> expectedPcm(codes.size()), actualPcm(codes.size());
+
+    WebrtcKernels.mDecodeALaw(codes.data(), codes.size(), expectedPcm.data());
+    k.mDecodeALaw(codes.data(), codes.size(), actualPcm.data());
+    CHECK(expectedPcm == actualPcm);
+
+    WebrtcKernels.mDecodeULaw(codes.data(), codes.size(), expectedPcm.data());
+    k.mDecodeULaw(codes.data(), codes.size(), actualPcm.data());
+    CHECK(expectedPcm == actualPcm);
+}
+
+// Kernel must write exactly 'count' values; guard values around output catch overrun
+static void testTails(const G711::Kernels& k)
+{
+    const size_t guard = 8, offset = 1;
+    auto linear = allLinear();
+    auto codes = allCodes();
+
+    for (size_t count = 0; count < 64; count++)
+    {
+        // Inputs taken from different parts of range so every segment gets into tails
+        const int16_t* pcmIn = linear.data() + offset + count * 1021 % (linear.size() - 128);
+        const uint8_t* codeIn = codes.data() + offset + count * 3 % (codes.size() - 128);
+
+        for (auto encode: {&G711::Kernels::mEncodeALaw, &G711::Kernels::mEncodeULaw})
+        {
+            std::vector<uint8_t> expected(count + 2 * guard, 0xA5), actual(count + 2 * guard, 0xA5);
+            (WebrtcKernels.*encode)(pcmIn, count, expected.data() + guard + offset);
+            (k.*encode)(pcmIn, count, actual.data() + guard + offset);
+            CHECK(expected == actual);
+        }
+
+        for (auto decode: {&G711::Kernels::mDecodeALaw, &G711::Kernels::mDecodeULaw})
+        {
+            std::vector<int16_t> expected(count + 2 * guard, 0x5A5A), actual(count + 2 * guard, 0x5A5A);
+            (WebrtcKernels.*decode)(codeIn, count, expected.data() + guard + offset);
+            (k.*decode)(codeIn, count, actual.data() + guard + offset);
+            CHECK(expected == actual);
+        }
+    }
+}
+
+static void benchmark(const G711::Kernels& k)
+{
+    // 20 ms frame of 8 kHz audio, the size kernels get from codecs
+    const size_t frame = 160;
+    auto linear = allLinear();
+    auto codes = allCodes();
+    std::vector<uint8_t> encoded(frame);
+    std::vector<int16_t> decoded(frame);
+
+    // Encode walks linear samples by frame, decode shifts start over the first 64 codes; indices are separate
+    size_t pos = 0, codePos = 0;
+    double encodeTime = measure([&]
+    {
+        k.mEncodeALaw(linear.data() + pos, frame, encoded.data());
+        pos = (pos + frame) % (linear.size() - frame);
+    });
+    double decodeTime = measure([&]
+    {
+        k.mDecodeALaw(codes.data() + codePos, frame, decoded.data());
+        codePos = (codePos + 1) & 0x3F;
+    });
+    printf("%-8s A-law encode %7.1f Msamples/s, decode %7.1f Msamples/s\n", k.mName, frame * 1000.0 / encodeTime, frame * 1000.0 / decodeTime);
+
+    encodeTime = measure([&]
+    {
+        k.mEncodeULaw(linear.data() + pos, frame, encoded.data());
+        pos = (pos + frame) % (linear.size() - frame);
+    });
+    decodeTime = measure([&]
+    {
+        k.mDecodeULaw(codes.data() + codePos, frame, decoded.data());
+        codePos = (codePos + 1) & 0x3F;
+    });
+    printf("%-8s u-law encode %7.1f Msamples/s, decode %7.1f Msamples/s\n", k.mName, frame * 1000.0 / encodeTime, frame * 1000.0 / decodeTime);
+}
+
+int main(int argc, char* argv[])
+{
+    bool bench = benchRequested(argc, argv);
+    if (bench)
+        benchmark(WebrtcKernels);
+
+    for (G711::Variant v: Variants)
+    {
+        const G711::Kernels* k = G711::kernels(v);
+        if (!k)
+            continue;
+
+        printf("checking %s kernels\n", k->mName);
+        testExhaustive(*k);
+        testTails(*k);
+        if (bench)
+            benchmark(*k);
+    }
+
+    // Table variant is always there and dispatcher picks one of checked variants
+    CHECK(G711::kernels(G711::Variant::Table) != nullptr);
+    bool bestChecked = false;
+    for (G711::Variant v: Variants)
+        bestChecked |= G711::kernels(v) == &G711::best();
+    CHECK(bestChecked);
+
+    return testResult("g711_kernels_test");
+}
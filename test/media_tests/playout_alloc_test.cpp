@@ -0,0 +1,120 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// AudioStream playout tick (copyDataTo + mixer output) makes no heap allocations once stream is running.
+// With --bench reports time of single 10 ms tick.
+
+#include "media/MT_AudioStream.h"
+#include "media/MT_G711.h"
+#include "audio/Audio_Mixer.h"
+#include "helper/HL_StreamState.h"
+
+#include "test_helper.h"
+
+#include <arpa/inet.h>
+#include <cmath>
+#include <vector>
+
+using namespace MT;
+
+// Feeds 20 ms PCMU packets into stream and runs 10 ms playout ticks like Terminal::onSpkData() does
+class PlayoutLoop
+{
+public:
+    PlayoutLoop()
+        :mStream(makeSettings(), true), mSource("127.0.0.1", 40000), mOutput(AUDIO_SPK_BUFFER_SIZE)
+    {
+        mStream.setState((unsigned)StreamState::Receiving);
+    }
+
+    void tick()
+    {
+        // Packet every second tick keeps jitter buffer level stable
+        if (mTick++ % 2 == 0)
+            sendPacket();
+
+        uint64_t before = allocations();
+        playout();
+        mPlayoutAllocations += allocations() - before;
+    }
+
+    void playout()
+    {
+        if (mMixer.available() < AUDIO_SPK_BUFFER_SIZE)
+            mStream.copyDataTo(mMixer, AUDIO_SPK_BUFFER_SIZE - mMixer.available());
+        mMixer.getPcm(mOutput.data(), AUDIO_SPK_BUFFER_SIZE);
+    }
+
+    void sendPacket()
+    {
+        uint8_t packet[12 + 160];
+        packet[0] = 0x80;
+        packet[1] = 0;  // PCMU
+        *reinterpret_cast<uint16_t*>(packet + 2) = htons(static_cast<uint16_t>(mSeqno));
+        *reinterpret_cast<uint32_t*>(packet + 4) = htonl(mSeqno * 160);
+        *reinterpret_cast<uint32_t*>(packet + 8) = htonl(0x12345678);
+
+        int16_t pcm[160];
+        for (int i = 0; i < 160; i++)
+            pcm[i] = static_cast<int16_t>(8000 * sin((mSeqno * 160 + i) * 2 * M_PI * 440 / 8000));
+        G711::encodeULaw(pcm, 160, packet + 12);
+        mSeqno++;
+
+        mStream.dataArrived(PDatagramSocket(), packet, sizeof packet, mSource, std::chrono::system_clock::now());
+    }
+
+    uint64_t playoutAllocations() const { return mPlayoutAllocations; }
+    void resetAllocations() { mPlayoutAllocations = 0; }
+
+protected:
+    AudioStream mStream;
+    Audio::Mixer mMixer;
+    InternetAddress mSource;
+    std::vector<char> mOutput;
+    uint32_t mSeqno = 1;
+    uint64_t mTick = 0;
+    uint64_t mPlayoutAllocations = 0;
+
+    static CodecList::Settings makeSettings()
+    {
+        CodecList::Settings result;
+        result.mNativeRtpReceive = true;
+        return result;
+    }
+};
+
+static void testAllocations()
+{
+    PlayoutLoop loop;
+
+    // Warm up: prebuffering, codec creation, resamplers and scratch buffers
+    for (int i = 0; i < 500; i++)
+        loop.tick();
+
+    loop.resetAllocations();
+    for (int i = 0; i < 1000; i++)
+        loop.tick();
+    CHECK(loop.playoutAllocations() == 0);
+}
+
+static void benchmark()
+{
+    PlayoutLoop loop;
+    for (int i = 0; i < 500; i++)
+        loop.tick();
+
+    double tickTime = measure([&] { loop.tick(); });
+    printf("playout tick of single PCMU stream: %.0f ns\n", tickTime);
+}
+
+int main(int argc, char* argv[])
+{
+    testAllocations();
+
+    if (benchRequested(argc, argv))
+        benchmark();
+
+    return testResult("playout_alloc_test");
+}
@@ -0,0 +1,227 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// RtpBuffer ring: ordering, duplicates, gap accounting, high-water trimming and allocation-free steady state.
+// With --bench compares add + fetch cost against sorted vector buffer (previous implementation) at 2000 ms high-water.
+
+#include "media/MT_AudioReceiver.h"
+#include "helper/HL_Rtp.h"
+#include "helper/HL_RtpMemoryPool.h"
+
+#include "test_helper.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace MT;
+
+static const int PacketTime = 20;   // Milliseconds; 160 samples of G.711
+
+static std::shared_ptr<RTPPacket> makePacket(uint32_t seqno)
+{
+    static uint8_t payload[160] = {0};
+
+    RtpPacketView view;
+    view.mSeqno = static_cast<uint16_t>(seqno);
+    view.mTimestamp = seqno * 160;
+    view.mSsrc = 0x12345678;
+    view.mPayload = payload;
+    view.mPayloadLength = sizeof payload;
+    return RtpHelper::makePacket(view, seqno, jrtplib::RTPTime(seqno / 50, (seqno % 50) * 20000), &RtpMemoryPool::instance());
+}
+
+static void testOrder()
+{
+    Statistics stat;
+    RtpBuffer buffer(stat);
+
+    const uint32_t order[] = {1, 3, 2, 5, 4, 7, 6, 8, 10, 9};
+    for (uint32_t seqno: order)
+        CHECK(buffer.add(makePacket(seqno), std::chrono::milliseconds(PacketTime), 8000));
+    CHECK(buffer.getCount() == 10);
+    CHECK(buffer.findTimelength() == std::chrono::milliseconds(10 * PacketTime));
+
+    // Duplicate is rejected and counted
+    CHECK(!buffer.add(makePacket(4), std::chrono::milliseconds(PacketTime), 8000));
+    CHECK(stat.mDuplicatedRtp == 1);
+
+    for (uint32_t expected = 1; expected <= 10; expected++)
+    {
+        auto r = buffer.fetch();
+        CHECK(r.mStatus == RtpBuffer::FetchResult::Status::RegularPacket);
+        if (r.mPacket)
+            CHECK(r.mPacket->rtp()->GetExtendedSequenceNumber() == expected);
+    }
+    CHECK(buffer.getCount() == 0);
+    CHECK(buffer.findTimelength() == 0ms);
+}
+
+static void testGap()
+{
+    Statistics stat;
+    RtpBuffer buffer(stat);
+    buffer.setPrebuffer(0ms);
+
+    for (uint32_t seqno: {1, 2, 5, 6})
+        buffer.add(makePacket(seqno), std::chrono::milliseconds(PacketTime), 8000);
+
+    CHECK(buffer.fetch().mStatus == RtpBuffer::FetchResult::Status::RegularPacket);
+    CHECK(buffer.fetch().mStatus == RtpBuffer::FetchResult::Status::RegularPacket);
+
+    // Packet following the gap is reported and stays in buffer
+    auto r = buffer.fetch();
+    CHECK(r.mStatus == RtpBuffer::FetchResult::Status::Gap);
+    CHECK(r.mPacket && r.mPacket->rtp()->GetExtendedSequenceNumber() == 5);
+    CHECK(r.mLost == 2);
+    CHECK(stat.mPacketLoss == 2);
+    CHECK(stat.mPacketLossTimeline.size() == 1);
+    if (!stat.mPacketLossTimeline.empty())
+    {
+        CHECK(stat.mPacketLossTimeline[0].mStartSeqno == 2);
+        CHECK(stat.mPacketLossTimeline[0].mEndSeqno == 5);
+        CHECK(stat.mPacketLossTimeline[0].mGap == 2);
+    }
+
+    r = buffer.fetch();
+    CHECK(r.mStatus == RtpBuffer::FetchResult::Status::RegularPacket);
+    CHECK(r.mPacket && r.mPacket->rtp()->GetExtendedSequenceNumber() == 5);
+}
+
+static void testHighWater()
+{
+    Statistics stat;
+    RtpBuffer buffer(stat);
+    buffer.setHigh(2000ms);
+
+    for (uint32_t seqno = 1; seqno <= 150; seqno++)
+        buffer.add(makePacket(seqno), std::chrono::milliseconds(PacketTime), 8000);
+
+    buffer.trimToHighWater();
+    CHECK(buffer.findTimelength() <= 2000ms);
+    CHECK(buffer.findTimelength() == std::chrono::milliseconds(buffer.getCount() * PacketTime));
+}
+
+static void testAllocations()
+{
+    Statistics stat;
+    RtpBuffer buffer(stat);
+    buffer.setHigh(2000ms);
+
+    // Fill up to high-water and warm up packet pool
+    uint32_t seqno = 1;
+    for (; seqno <= 2000 / PacketTime; seqno++)
+        buffer.add(makePacket(seqno), std::chrono::milliseconds(PacketTime), 8000);
+    for (int i = 0; i < 1000; i++, seqno++)
+    {
+        buffer.add(makePacket(seqno), std::chrono::milliseconds(PacketTime), 8000);
+        buffer.fetch();
+    }
+
+    // Packets are made outside of measured part
+    uint64_t counted = 0;
+    for (int i = 0; i < 1000; i++, seqno++)
+    {
+        auto packet = makePacket(seqno);
+        uint64_t before = allocations();
+        buffer.add(packet, std::chrono::milliseconds(PacketTime), 8000);
+        auto r = buffer.fetch();
+        counted += allocations() - before;
+    }
+    CHECK(counted == 0);
+}
+
+// Previous RtpBuffer algorithm: duplicate scan, duration sum and sort on every add, erase from front on fetch
+class VectorBuffer
+{
+public:
+    void add(const std::shared_ptr<RTPPacket>& packet, std::chrono::milliseconds timelength)
+    {
+        uint32_t newSeqno = packet->GetExtendedSequenceNumber(), minno = UINT32_MAX;
+        for (auto& p: mPackets)
+        {
+            if (p.mRtp->GetExtendedSequenceNumber() == newSeqno)
+                return;
+            minno = std::min(minno, p.mRtp->GetExtendedSequenceNumber());
+        }
+
+        if (newSeqno > minno || timelengthSum() < mHigh)
+        {
+            mPackets.push_back({packet, timelength});
+            std::sort(mPackets.begin(), mPackets.end(), [](const Item& a, const Item& b)
+                      { return a.mRtp->GetExtendedSequenceNumber() < b.mRtp->GetExtendedSequenceNumber(); });
+            timelengthSum();
+        }
+    }
+
+    void fetch()
+    {
+        while (timelengthSum() > mHigh && !mPackets.empty())
+            mPackets.erase(mPackets.begin());
+        if (!mPackets.empty())
+            mPackets.erase(mPackets.begin());
+    }
+
+protected:
+    struct Item
+    {
+        std::shared_ptr<RTPPacket> mRtp;
+        std::chrono::milliseconds mTimelength;
+    };
+    std::vector<Item> mPackets;
+    std::chrono::milliseconds mHigh = 2000ms;
+
+    std::chrono::milliseconds timelengthSum() const
+    {
+        std::chrono::milliseconds result = 0ms;
+        for (auto& p: mPackets)
+            result += p.mTimelength;
+        return result;
+    }
+};
+
+static void benchmark()
+{
+    // Both buffers are kept full - 2000 ms of 20 ms packets - and get add + fetch per step.
+    // Packet creation is measured separately and subtracted.
+    const uint32_t window = 2000 / PacketTime;
+
+    VectorBuffer vb;
+    uint32_t vseqno = 1;
+    for (; vseqno <= window; vseqno++)
+        vb.add(makePacket(vseqno), std::chrono::milliseconds(PacketTime));
+    double vectorTime = measure([&]
+    {
+        vb.add(makePacket(vseqno++), std::chrono::milliseconds(PacketTime));
+        vb.fetch();
+    });
+
+    Statistics stat;
+    RtpBuffer rb(stat);
+    rb.setHigh(2000ms);
+    uint32_t rseqno = 1;
+    for (; rseqno <= window; rseqno++)
+        rb.add(makePacket(rseqno), std::chrono::milliseconds(PacketTime), 8000);
+    double ringTime = measure([&]
+    {
+        rb.add(makePacket(rseqno++), std::chrono::milliseconds(PacketTime), 8000);
+        rb.fetch();
+    });
+
+    double makeTime = measure([&] { makePacket(1); });
+    printf("add + fetch at 2000 ms high-water: sorted vector %.0f ns, ring %.0f ns\n", vectorTime - makeTime, ringTime - makeTime);
+}
+
+int main(int argc, char* argv[])
+{
+    testOrder();
+    testGap();
+    testHighWater();
+    testAllocations();
+
+    if (benchRequested(argc, argv))
+        benchmark();
+
+    return testResult("rtp_buffer_test");
+}
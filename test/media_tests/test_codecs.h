@@ -0,0 +1,129 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Codecs used by media tests and RTP payloads to feed them
+
+#ifndef __TEST_CODECS_H
+#define __TEST_CODECS_H
+
+#include "media/MT_CodecList.h"
+#include "media/MT_Codec.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct TestCodec
+{
+    const char* mName;
+    int         mPayloadType;
+};
+
+static const TestCodec TestCodecs[] = {
+    { "pcmu",   0   },
+    { "pcma",   8   },
+    { "g722",   9   },
+    { "opus",   106 },
+    { "amrnb",  97  },
+    { "amrwb",  98  }
+};
+
+inline MT::CodecList::Settings testCodecSettings()
+{
+    MT::CodecList::Settings result;
+    result.mOpusSpec.push_back(MT::CodecList::Settings::OpusSpec(106, 48000, 1));
+    // Bandwidth-efficient AMR - octet-aligned AMR-NB payloads are not decoded
+    result.mAmrNbPayloadType.insert(97);
+    result.mAmrWbPayloadType.insert(98);
+    return result;
+}
+
+// Shared by all tests of executable; codecs are created by its factories
+inline MT::CodecList& testCodecList()
+{
+    static MT::CodecList list(testCodecSettings());
+    return list;
+}
+
+inline MT::PCodec createTestCodec(int payloadType)
+{
+    return testCodecList().createCodecByPayloadType(payloadType);
+}
+
+// Speech-like test signal: two tones with slow amplitude change, frame by frame
+inline std::vector<int16_t> testSignal(int samplerate, int channels, int frameIndex, int frameSamples)
+{
+    std::vector<int16_t> result(frameSamples * channels);
+    for (int i = 0; i < frameSamples; i++)
+    {
+        double t = double(frameIndex * frameSamples + i) / samplerate;
+        double v = (0.5 + 0.4 * sin(2 * M_PI * 3 * t)) * (6000 * sin(2 * M_PI * 440 * t) + 3000 * sin(2 * M_PI * 1250 * t));
+        for (int c = 0; c < channels; c++)
+            result[i * channels + c] = static_cast<int16_t>(v);
+    }
+    return result;
+}
+
+// Bandwidth-efficient AMR payload (RFC 4867) with highest speech mode. Codec encoders cannot produce
+// RTP payloads, so speech bits are pseudo-random - decoder accepts any bits of valid mode.
+// Every fifth payload carries two frames.
+inline std::vector<uint8_t> amrTestPayload(bool wideband, int index)
+{
+    const int mode = wideband ? 8 : 7, bits = wideband ? 477 : 244;
+    const int frames = index % 5 == 4 ? 2 : 1;
+
+    std::vector<uint8_t> result((4 + frames * (6 + bits) + 7) / 8, 0);
+    size_t position = 0;
+    auto put = [&](uint32_t value, int count)
+    {
+        for (int i = count - 1; i >= 0; i--, position++)
+        {
+            if (value & (1u << i))
+                result[position / 8] |= 0x80 >> (position % 8);
+        }
+    };
+
+    put(15, 4);                                         // CMR - no mode request
+    for (int f = 0; f < frames; f++)
+        put((f < frames - 1 ? 0x20 : 0) | (mode << 1) | 1, 6);  // F, FT, Q
+
+    uint32_t seed = 2166136261u ^ (index * 16777619u);
+    for (int i = 0; i < frames * bits; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        put(seed >> 31, 1);
+    }
+    return result;
+}
+
+// Returns RTP payloads of 'frames' consecutive frames of test signal encoded by new codec
+inline std::vector<std::vector<uint8_t>> testPayloads(int payloadType, int frames)
+{
+    std::vector<std::vector<uint8_t>> result;
+    MT::CodecList::Settings settings = testCodecSettings();
+    if (settings.isAmrNb(payloadType) || settings.isAmrWb(payloadType))
+    {
+        for (int i = 0; i < frames; i++)
+            result.push_back(amrTestPayload(settings.isAmrWb(payloadType), i));
+        return result;
+    }
+
+    MT::PCodec encoder = createTestCodec(payloadType);
+    if (!encoder)
+        return result;
+
+    int frameSamples = encoder->pcmLength() / 2 / encoder->channels();
+    std::vector<uint8_t> buffer(4096);
+    for (int i = 0; i < frames; i++)
+    {
+        auto pcm = testSignal(encoder->samplerate(), encoder->channels(), i, frameSamples);
+        auto r = encoder->encode({reinterpret_cast<const uint8_t*>(pcm.data()), pcm.size() * 2}, buffer);
+        if (r.mEncoded)
+            result.emplace_back(buffer.begin(), buffer.begin() + r.mEncoded);
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,88 @@
+/* Copyright(C) 2007-2026 VoIP objects (voipobjects.com)
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Helpers shared by media tests. Include it into exactly one source file of test executable -
+// it replaces global operator new / delete to count heap allocations.
+
+#ifndef __TEST_HELPER_H
+#define __TEST_HELPER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+static std::atomic<uint64_t> AllocationCounter(0);
+
+void* operator new(size_t size)
+{
+    AllocationCounter.fetch_add(1, std::memory_order_relaxed);
+    if (void* result = malloc(size ? size : 1))
+        return result;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept                  { free(p); }
+void operator delete[](void* p) noexcept                { free(p); }
+void operator delete(void* p, size_t) noexcept          { free(p); }
+void operator delete[](void* p, size_t) noexcept        { free(p); }
+
+// Number of operator new calls made so far by all threads
+inline uint64_t allocations()
+{
+    return AllocationCounter.load(std::memory_order_relaxed);
+}
+
+static int FailedChecks = 0;
+
+#define CHECK(X) \
+    do { if (!(X)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #X); FailedChecks++; } } while (0)
+
+// Returns exit code of test
+inline int testResult(const char* name)
+{
+    if (FailedChecks)
+        fprintf(stderr, "%s: %d check(s) failed\n", name, FailedChecks);
+    else
+        printf("%s: passed\n", name);
+    return FailedChecks ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+inline bool benchRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--bench") == 0)
+            return true;
+    }
+    return false;
+}
+
+// Runs f() repeatedly for about 'duration'; returns average time of single call in nanoseconds
+template <typename F>
+double measure(F&& f, std::chrono::milliseconds duration = std::chrono::milliseconds(300))
+{
+    using clock = std::chrono::steady_clock;
+    uint64_t calls = 0;
+    auto start = clock::now(), finish = start + duration;
+    auto now = start;
+    while (now < finish)
+    {
+        for (int i = 0; i < 16; i++)
+            f();
+        calls += 16;
+        now = clock::now();
+    }
+    return std::chrono::duration<double, std::nano>(now - start).count() / calls;
+}
+
+#endif